@@ -1526,7 +1526,7 @@ static inline char* duplicateStringValue(const char* value,
   if (length >= (unsigned)Value::maxInt)
     length = Value::maxInt - 1;
 
-  char* newString = static_cast<char*>(malloc(length + 1));
+  char* newString = static_cast<char*>(allocateBlock(length + 1));
   JSON_ASSERT_MESSAGE(newString != 0,
                       "in Json::Value::duplicateStringValue(): "
                       "Failed to allocate string value buffer");
@@ -1537,7 +1537,104 @@ static inline char* duplicateStringValue(const char* value,
 
 /** Free the string duplicated by duplicateStringValue().
  */
-static inline void releaseStringValue(char* value) { free(value); }
+static inline void releaseStringValue(char* value) { releaseBlock(value); }
+
+static inline Value::ObjectValues* newObjectValues() {
+  return new (allocateBlock(sizeof(Value::ObjectValues))) Value::ObjectValues();
+}
+
+static inline Value::ObjectValues*
+newObjectValues(const Value::ObjectValues& other) {
+  return new (allocateBlock(sizeof(Value::ObjectValues)))
+      Value::ObjectValues(other);
+}
+
+static inline void deleteObjectValues(Value::ObjectValues* map) {
+  typedef Value::ObjectValues ObjectValues;
+  map->~ObjectValues();
+  releaseBlock(map);
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Arena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+thread_local Arena* Arena::current_ = 0;
+
+Arena::Arena(size_t chunkSize)
+    : chunks_(0), cursor_(0), end_(0), chunkSize_(chunkSize) {}
+
+Arena::~Arena() {
+  while (chunks_) {
+    Chunk* next = chunks_->next_;
+    free(chunks_);
+    chunks_ = next;
+  }
+}
+
+void Arena::addChunk(size_t size) {
+  // Chunks grow geometrically so that big documents need few of them.
+  if (chunks_ && size < chunks_->size_ * 2)
+    size = chunks_->size_ * 2;
+  if (size < chunkSize_)
+    size = chunkSize_;
+  Chunk* chunk = static_cast<Chunk*>(malloc(sizeof(Chunk) + size + 8));
+  JSON_ASSERT_MESSAGE(chunk != 0, "in Json::Arena::allocate(): out of memory");
+  chunk->next_ = chunks_;
+  chunk->size_ = size;
+  chunks_ = chunk;
+  cursor_ = reinterpret_cast<char*>(chunk + 1);
+  cursor_ += (8 - reinterpret_cast<size_t>(cursor_) % 8) % 8;
+  end_ = cursor_ + size;
+}
+
+void* Arena::allocate(size_t size) {
+  size = (size + 7) & ~size_t(7);
+  if (size_t(end_ - cursor_) < size)
+    addChunk(size);
+  void* block = cursor_;
+  cursor_ += size;
+  return block;
+}
+
+void Arena::reset() {
+  if (!chunks_)
+    return;
+  // Keep the oldest chunk: it is the one sized for a typical document.
+  while (chunks_->next_) {
+    Chunk* next = chunks_->next_;
+    free(chunks_);
+    chunks_ = next;
+  }
+  // Rewind it in place instead of freeing and reallocating it.
+  cursor_ = reinterpret_cast<char*>(chunks_ + 1);
+  cursor_ += (8 - reinterpret_cast<size_t>(cursor_) % 8) % 8;
+  end_ = cursor_ + chunks_->size_;
+}
+
+// Every block starts with an 8-byte header telling whether it lives in an
+// arena (and must not be freed) or on the heap.
+void* allocateBlock(size_t size) {
+  Arena* arena = Arena::current();
+  char* block = static_cast<char*>(arena ? arena->allocate(size + 8)
+                                         : malloc(size + 8));
+  if (!block)
+    return 0;
+  *reinterpret_cast<size_t*>(block) = arena ? 1 : 0;
+  return block + 8;
+}
+
+void releaseBlock(void* block) {
+  if (!block)
+    return;
+  char* header = static_cast<char*>(block) - 8;
+  if (!*reinterpret_cast<size_t*>(header))
+    free(header);
+}
 
 } // namespace Json
 
@@ -1600,25 +1697,46 @@ void Value::CommentInfo::setComment(const char* text) {
 Value::CZString::CZString(ArrayIndex index) : cstr_(0), index_(index) {}
 
 Value::CZString::CZString(const char* cstr, DuplicationPolicy allocate)
-    : cstr_(allocate == duplicate ? duplicateStringValue(cstr) : cstr),
-      index_(allocate) {}
+    : cstr_(cstr), index_(allocate) {
+  if (allocate == duplicate)
+    duplicateFrom(cstr);
+}
 
 Value::CZString::CZString(const CZString& other)
-    : cstr_(other.index_ != noDuplication && other.cstr_ != 0
-                ? duplicateStringValue(other.cstr_)
-                : other.cstr_),
+    : cstr_(other.cstr_),
       index_(other.cstr_
                  ? (other.index_ == noDuplication ? noDuplication : duplicate)
-                 : other.index_) {}
+                 : other.index_) {
+  if (other.index_ != noDuplication && other.cstr_ != 0)
+    duplicateFrom(other.cstr_);
+}
 
 Value::CZString::~CZString() {
-  if (cstr_ && index_ == duplicate)
+  if (cstr_ && index_ == duplicate && cstr_ != small_)
     releaseStringValue(const_cast<char*>(cstr_));
 }
 
+void Value::CZString::duplicateFrom(const char* cstr) {
+  size_t length = strlen(cstr);
+  if (length < sizeof(small_)) {
+    memcpy(small_, cstr, length + 1);
+    cstr_ = small_;
+  } else
+    cstr_ = duplicateStringValue(cstr, (unsigned int)length);
+}
+
 void Value::CZString::swap(CZString& other) {
+  bool isSmall = cstr_ == small_, otherIsSmall = other.cstr_ == other.small_;
   std::swap(cstr_, other.cstr_);
   std::swap(index_, other.index_);
+  char small[sizeof(small_)];
+  memcpy(small, small_, sizeof(small_));
+  memcpy(small_, other.small_, sizeof(small_));
+  memcpy(other.small_, small, sizeof(small_));
+  if (otherIsSmall)
+    cstr_ = small_;
+  if (isSmall)
+    other.cstr_ = other.small_;
 }
 
 Value::CZString& Value::CZString::operator=(CZString other) {
@@ -1682,7 +1800,7 @@ Value::Value(ValueType type)
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
   case objectValue:
-    value_.map_ = new ObjectValues();
+    value_.map_ = newObjectValues();
     break;
 #else
   case arrayValue:
@@ -1855,7 +1973,7 @@ Value::Value(const Value& other)
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
   case objectValue:
-    value_.map_ = new ObjectValues(*other.value_.map_);
+    value_.map_ = newObjectValues(*other.value_.map_);
     break;
 #else
   case arrayValue:
@@ -1893,7 +2011,7 @@ Value::~Value() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
   case objectValue:
-    delete value_.map_;
+    deleteObjectValues(value_.map_);
     break;
 #else
   case arrayValue:
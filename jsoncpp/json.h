@@ -375,6 +375,8 @@ public:
 #if !defined(JSON_IS_AMALGAMATION)
 #include "forwards.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -424,6 +426,109 @@ enum CommentPlacement {
 //   typedef CppTL::AnyEnumerator<const Value &> EnumValues;
 //# endif
 
+/** \brief Bump allocator for Value trees that are built and dropped as a whole.
+ *
+ * While an Arena is installed with Arena::Scope, every string, object member
+ * name and object/array node allocated by Value comes from the arena instead of
+ * the general heap. Releasing such memory is a no-op; all of it is returned at
+ * once when the arena is reset or destroyed. Memory allocated outside a scope
+ * keeps using malloc/new, so values may be copied out of an arena freely, but
+ * every value allocated in an arena must be destroyed before the arena is.
+ * The installed arena is per thread: a Scope only affects allocations made by
+ * the thread that created it, but one Arena must not be used by two threads at
+ * the same time.
+ *
+ * Example of usage:
+ * \code
+ * Json::Arena arena;
+ * Json::Arena::Scope scope(arena);
+ * Json::Value root;
+ * reader.parse(document, root);
+ * \endcode
+ */
+class JSON_API Arena {
+public:
+  explicit Arena(size_t chunkSize = 64 * 1024);
+  ~Arena();
+
+  /// Returns 8-byte aligned storage; never fails short of running out of memory.
+  void* allocate(size_t size);
+  /// Drops everything but the first chunk, which is kept (emptied) for reuse.
+  void reset();
+
+  /// Arena used by Value allocations on this thread, or 0 when the heap is used.
+  static Arena* current() { return current_; }
+
+  /// Installs an arena for the lifetime of the scope.
+  class JSON_API Scope {
+  public:
+    explicit Scope(Arena& arena) : previous_(current_) { current_ = &arena; }
+    ~Scope() { current_ = previous_; }
+
+  private:
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+    Arena* previous_;
+  };
+
+private:
+  struct Chunk {
+    Chunk* next_;
+    size_t size_;
+  };
+
+  Arena(const Arena&);
+  Arena& operator=(const Arena&);
+  void addChunk(size_t size);
+
+  static thread_local Arena* current_;
+  Chunk* chunks_;
+  char* cursor_;
+  char* end_;
+  size_t chunkSize_;
+};
+
+/// Allocates from the current arena if any, otherwise from the heap; the block
+/// remembers where it came from so that releaseBlock() does the right thing.
+JSON_API void* allocateBlock(size_t size);
+JSON_API void releaseBlock(void* block);
+
+/** \brief STL allocator routing container nodes through allocateBlock().
+ */
+template <typename T> class ArenaAllocator {
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  template <typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+  ArenaAllocator() {}
+  template <typename U> ArenaAllocator(const ArenaAllocator<U>&) {}
+
+  pointer address(reference x) const { return &x; }
+  const_pointer address(const_reference x) const { return &x; }
+  pointer allocate(size_type n, const void* = 0) {
+    return static_cast<pointer>(allocateBlock(n * sizeof(T)));
+  }
+  void deallocate(pointer p, size_type) { releaseBlock(p); }
+  size_type max_size() const { return size_type(-1) / sizeof(T); }
+  void construct(pointer p, const T& value) { new (p) T(value); }
+  void destroy(pointer p) { p->~T(); }
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+  return true;
+}
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+  return false;
+}
+
 /** \brief Lightweight wrapper to tag static string.
  *
  * Value constructor and objectValue member assignement takes advantage of the
@@ -546,13 +651,21 @@ private:
 
   private:
     void swap(CZString& other);
+    void duplicateFrom(const char* cstr);
     const char* cstr_;
     ArrayIndex index_;
+    /// Short member names ("0", "action", ...) are stored here instead of
+    /// being duplicated on the heap.
+    char small_[8];
   };
 
 public:
 #ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
+  typedef std::map<CZString,
+                   Value,
+                   std::less<CZString>,
+                   ArenaAllocator<std::pair<const CZString, Value> > >
+      ObjectValues;
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
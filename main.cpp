@@ -26,6 +26,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <climits>
 #include <iostream>
 #include <algorithm>
 #include <string>
@@ -33,6 +34,9 @@
 #include <stack>
 #include <stdexcept>
 #include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include "jsoncpp/json.h"
 
 #define FIELD_MAX_HEIGHT 20
@@ -41,6 +45,12 @@
 #define MAX_PLAYER_COUNT 4
 #define MAX_TURN 100
 
+// 平台会生成的场地尺寸（高, 宽），这些尺寸的演算与蒙特卡洛模拟会按编译期常量特化
+#define PACMAN_BOARD_ROWS(F, W) F(6, W) F(7, W) F(8, W) F(9, W) F(10, W) F(11, W) F(12, W)
+#define PACMAN_BOARD_SIZES(F) \
+	PACMAN_BOARD_ROWS(F, 6) PACMAN_BOARD_ROWS(F, 7) PACMAN_BOARD_ROWS(F, 8) PACMAN_BOARD_ROWS(F, 9) \
+	PACMAN_BOARD_ROWS(F, 10) PACMAN_BOARD_ROWS(F, 11) PACMAN_BOARD_ROWS(F, 12)
+
 using std::string;
 using std::swap;
 using std::cin;
@@ -56,12 +66,52 @@ using std::runtime_error;
 	unsigned int RR = 1478417566;
 #endif
 
-inline double Rand()
+inline unsigned int RandInt()
 {
 	RR = RR*RR*103 + RR*101 + 1000000007;
-	return 1.0 * RR / (long long)0xFFFFFFFF;
+	return RR;
+}
+inline double Rand()
+{
+	return 1.0 * RandInt() / (long long)0xFFFFFFFF;
 }
 
+// 单回合性能剖析：主流程每个阶段结束时 ProfileLap 记下距上一次的耗时（steady_clock，微秒），
+// 另有模拟次数、演算次数、BFS 出队节点数三个计数器；编译时定义 _PACMAN_NO_PROFILE 则全部成为空操作
+#include <chrono>
+
+enum ProfilePhase {PF_READ, PF_DATA, PF_DIS, PF_DEATH, PF_WALL, PF_CANDY, PF_ROUND, PF_FIGHT = PF_ROUND + 8, PF_FINAL, PF_WRITE, PF_COUNT};
+enum ProfileCounter {PC_ROLLOUT, PC_NEXTTURN, PC_BFS, PC_COUNT};
+
+struct TurnProfile
+{
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start, last;
+	long long phase[PF_COUNT], counter[PC_COUNT];
+	
+	TurnProfile() : start(Clock::now()), last(start)
+	{
+		memset(phase, 0, sizeof(phase)), memset(counter, 0, sizeof(counter));
+	}
+	inline long long Since(Clock::time_point t) const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t).count();
+	}
+	inline void Lap(int p)
+	{
+		Clock::time_point t = Clock::now();
+		phase[p] += std::chrono::duration_cast<std::chrono::microseconds>(t - last).count(), last = t;
+	}
+} Profile;
+
+#ifndef _PACMAN_NO_PROFILE
+inline void ProfileLap(int p){Profile.Lap(p);}
+inline void ProfileCount(int c){++Profile.counter[c];}
+#else
+inline void ProfileLap(int){}
+inline void ProfileCount(int){}
+#endif
+
 string data, globalData; // 这是回合之间可以传递的信息
 
 // 平台提供的吃豆人相关逻辑处理程序（直接照搬
@@ -183,8 +233,7 @@ namespace Pacman
 	{
 		FieldProp newFruits[MAX_GENERATOR_COUNT * 8];
 		int newFruitCount;
-	} newFruits[MAX_TURN];
-	int newFruitsCount = 0;
+	};
 
 	// 状态转移记录结构
 	struct TurnStateTransfer
@@ -209,6 +258,527 @@ namespace Pacman
 		int strengthDelta[MAX_PLAYER_COUNT];
 	};
 
+	// Botzone 请求的快速解析器：只认识本游戏的请求格式，一遍扫描直接取出需要的字段，不建立 Json::Value 树
+	// 遇到任何意料之外的结构都返回 false，由调用者退回到 jsoncpp
+	class RequestReader
+	{
+	public:
+		int id, height, width;
+		int GENERATOR_INTERVAL, LARGE_FRUIT_DURATION, LARGE_FRUIT_ENHANCEMENT, SKILL_COST;
+		int staticField[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH], contentField[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
+
+		// requests 数组的长度，actions[i] 是第 i 个 request 中各玩家的动作（缺省为 0，与 jsoncpp 的 asInt 一致）
+		int requestCount;
+		int actions[MAX_TURN + 1][MAX_PLAYER_COUNT];
+
+		string data, globalData;
+
+		bool Parse(const char *str)
+		{
+			p = str;
+			id = height = width = 0;
+			GENERATOR_INTERVAL = LARGE_FRUIT_DURATION = LARGE_FRUIT_ENHANCEMENT = SKILL_COST = 0;
+			memset(staticField, 0, sizeof(staticField));
+			memset(contentField, 0, sizeof(contentField));
+			memset(actions, 0, sizeof(actions));
+			requestCount = 0;
+			data.clear();
+			globalData.clear();
+
+			char key[32];
+			if (!Consume('{'))
+				return false;
+			if (!Consume('}'))
+			{
+				do
+				{
+					if (!Key(key))
+						return false;
+					bool ok;
+					if (!strcmp(key, "requests"))
+						ok = Requests();
+					else if (!strcmp(key, "data"))
+						ok = String(&data);
+					else if (!strcmp(key, "globaldata"))
+						ok = String(&globalData);
+					else
+						ok = Skip();
+					if (!ok)
+						return false;
+				} while (Consume(','));
+				if (!Consume('}'))
+					return false;
+			}
+
+			// 场地尺寸超出数组范围（或者缺失）的输入不在这里处理
+			return height >= 1 && height <= FIELD_MAX_HEIGHT && width >= 1 && width <= FIELD_MAX_WIDTH;
+		}
+
+	private:
+		const char *p;
+
+		inline void Blank()
+		{
+			while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+				p++;
+		}
+
+		inline bool Consume(char ch)
+		{
+			Blank();
+			if (*p != ch)
+				return false;
+			p++;
+			return true;
+		}
+
+		// 读入一个不含转义的键名和随后的冒号
+		bool Key(char *key)
+		{
+			if (!Consume('"'))
+				return false;
+			int len = 0;
+			while (*p != '"')
+			{
+				if (!*p || *p == '\\' || len == 31)
+					return false;
+				key[len++] = *p++;
+			}
+			key[len] = 0;
+			p++;
+			return Consume(':');
+		}
+
+		// 只接受整数，小数、指数都交给 jsoncpp
+		bool Int(int &x)
+		{
+			Blank();
+			bool neg = *p == '-';
+			if (neg)
+				p++;
+			if (*p < '0' || *p > '9')
+				return false;
+			x = 0;
+			while (*p >= '0' && *p <= '9')
+			{
+				// 超出 int 范围的数交给 jsoncpp
+				int digit = *p++ - '0';
+				if (x > (INT_MAX - digit) / 10)
+					return false;
+				x = x * 10 + digit;
+			}
+			if (*p == '.' || *p == 'e' || *p == 'E')
+				return false;
+			if (neg)
+				x = -x;
+			return true;
+		}
+
+		inline int Hex4()
+		{
+			int x = 0;
+			for (int i = 0; i < 4; i++, p++)
+			{
+				x <<= 4;
+				if (*p >= '0' && *p <= '9')
+					x |= *p - '0';
+				else if (*p >= 'a' && *p <= 'f')
+					x |= *p - 'a' + 10;
+				else if (*p >= 'A' && *p <= 'F')
+					x |= *p - 'A' + 10;
+				else
+					return -1;
+			}
+			return x;
+		}
+
+		// 读入字符串，out 为 NULL 时只跳过；null 视为空串
+		bool String(string *out)
+		{
+			Blank();
+			if (!strncmp(p, "null", 4))
+			{
+				p += 4;
+				return true;
+			}
+			if (*p++ != '"')
+				return false;
+			while (true)
+			{
+				const char *begin = p;
+				while (*p && *p != '"' && *p != '\\')
+					p++;
+				if (out)
+					out->append(begin, p);
+				if (!*p)
+					return false;
+				if (*p++ == '"')
+					return true;
+
+				char esc = *p++, ch;
+				switch (esc)
+				{
+				case '"': ch = '"'; break;
+				case '\\': ch = '\\'; break;
+				case '/': ch = '/'; break;
+				case 'b': ch = '\b'; break;
+				case 'f': ch = '\f'; break;
+				case 'n': ch = '\n'; break;
+				case 'r': ch = '\r'; break;
+				case 't': ch = '\t'; break;
+				case 'u':
+				{
+					int cp = Hex4();
+					if (cp < 0)
+						return false;
+					if (cp >= 0xD800 && cp <= 0xDBFF)
+					{
+						if (p[0] != '\\' || p[1] != 'u')
+							return false;
+						p += 2;
+						int low = Hex4();
+						if (low < 0xDC00 || low > 0xDFFF)
+							return false;
+						cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+					}
+					if (out)
+					{
+						// 编码为 UTF-8
+						if (cp < 0x80)
+							*out += (char)cp;
+						else if (cp < 0x800)
+						{
+							*out += (char)(0xC0 | (cp >> 6));
+							*out += (char)(0x80 | (cp & 0x3F));
+						}
+						else if (cp < 0x10000)
+						{
+							*out += (char)(0xE0 | (cp >> 12));
+							*out += (char)(0x80 | ((cp >> 6) & 0x3F));
+							*out += (char)(0x80 | (cp & 0x3F));
+						}
+						else
+						{
+							*out += (char)(0xF0 | (cp >> 18));
+							*out += (char)(0x80 | ((cp >> 12) & 0x3F));
+							*out += (char)(0x80 | ((cp >> 6) & 0x3F));
+							*out += (char)(0x80 | (cp & 0x3F));
+						}
+					}
+					continue;
+				}
+				default:
+					return false;
+				}
+				if (out)
+					*out += ch;
+			}
+		}
+
+		// 跳过任意一个值
+		bool Skip()
+		{
+			Blank();
+			char key[32];
+			switch (*p)
+			{
+			case '{':
+				p++;
+				if (Consume('}'))
+					return true;
+				do
+					if (!Key(key) || !Skip())
+						return false;
+				while (Consume(','));
+				return Consume('}');
+			case '[':
+				p++;
+				if (Consume(']'))
+					return true;
+				do
+					if (!Skip())
+						return false;
+				while (Consume(','));
+				return Consume(']');
+			case '"':
+				return String(NULL);
+			case 't':
+				return !strncmp(p, "true", 4) && (p += 4);
+			case 'f':
+				return !strncmp(p, "false", 5) && (p += 5);
+			case 'n':
+				return !strncmp(p, "null", 4) && (p += 4);
+			default:
+			{
+				const char *begin = p;
+				while ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E')
+					p++;
+				return p != begin;
+			}
+			}
+		}
+
+		bool Matrix(int m[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH])
+		{
+			if (!Consume('['))
+				return false;
+			if (Consume(']'))
+				return true;
+			int r = 0;
+			do
+			{
+				if (r == FIELD_MAX_HEIGHT || !Consume('['))
+					return false;
+				if (!Consume(']'))
+				{
+					int c = 0;
+					do
+						if (c == FIELD_MAX_WIDTH || !Int(m[r][c++]))
+							return false;
+					while (Consume(','));
+					if (!Consume(']'))
+						return false;
+				}
+				r++;
+			} while (Consume(','));
+			return Consume(']');
+		}
+
+		// 第一个 request：场地信息
+		bool Field()
+		{
+			char key[32];
+			if (!Consume('{'))
+				return false;
+			if (Consume('}'))
+				return true;
+			do
+			{
+				if (!Key(key))
+					return false;
+				bool ok;
+				if (!strcmp(key, "id"))
+					ok = Int(id);
+				else if (!strcmp(key, "height"))
+					ok = Int(height);
+				else if (!strcmp(key, "width"))
+					ok = Int(width);
+				else if (!strcmp(key, "static"))
+					ok = Matrix(staticField);
+				else if (!strcmp(key, "content"))
+					ok = Matrix(contentField);
+				else if (!strcmp(key, "GENERATOR_INTERVAL"))
+					ok = Int(GENERATOR_INTERVAL);
+				else if (!strcmp(key, "LARGE_FRUIT_DURATION"))
+					ok = Int(LARGE_FRUIT_DURATION);
+				else if (!strcmp(key, "LARGE_FRUIT_ENHANCEMENT"))
+					ok = Int(LARGE_FRUIT_ENHANCEMENT);
+				else if (!strcmp(key, "SKILL_COST"))
+					ok = Int(SKILL_COST);
+				else
+					ok = Skip();
+				if (!ok)
+					return false;
+			} while (Consume(','));
+			return Consume('}');
+		}
+
+		// 之后的 request：{"0":{"action":x},"1":...}
+		bool Turn(int *turnActions)
+		{
+			char key[32], inner[32];
+			if (!Consume('{'))
+				return false;
+			if (Consume('}'))
+				return true;
+			do
+			{
+				if (!Key(key))
+					return false;
+				int player = key[0] - '0';
+				if (key[1] || player < 0 || player >= MAX_PLAYER_COUNT)
+				{
+					if (!Skip())
+						return false;
+					continue;
+				}
+				if (!Consume('{'))
+					return false;
+				if (!Consume('}'))
+				{
+					do
+						if (!Key(inner) || !(strcmp(inner, "action") ? Skip() : Int(turnActions[player])))
+							return false;
+					while (Consume(','));
+					if (!Consume('}'))
+						return false;
+				}
+			} while (Consume(','));
+			return Consume('}');
+		}
+
+		bool Requests()
+		{
+			if (!Consume('['))
+				return false;
+			if (Consume(']'))
+				return true;
+			do
+			{
+				if (requestCount > MAX_TURN)
+					return false;
+				if (!(requestCount ? Turn(actions[requestCount]) : Field()))
+					return false;
+				requestCount++;
+			} while (Consume(','));
+			return Consume(']');
+		}
+	};
+
+	// 回复的直接生成器：按 Json::FastWriter 的格式（键按字典序）把固定结构的回复转义写进预先分配的缓冲区，
+	// 最后一次 write(2) 输出，不经过 Json::Value 和临时字符串
+	class ResponseWriter
+	{
+	public:
+		ResponseWriter() : buf(1 << 16) { }
+
+		// 生成回复，返回长度，内容在 Buffer() 中
+		// 给出 debugText 时 debug 字段输出这段文字，否则输出整数 debug
+		size_t Format(int action, const string &tauntText, const string &data, const string &globalData, int debug,
+			const char *debugText = NULL, size_t debugLen = 0)
+		{
+			// 每个字符最多转义成 6 个字符
+			size_t bound = 128 + 6 * (tauntText.size() + data.size() + globalData.size() + debugLen);
+			if (buf.size() < bound)
+				buf.resize(bound);
+			p = &buf[0];
+
+			Raw("{\"data\":");
+			Quoted(data);
+			Raw(",\"debug\":");
+			if (debugText)
+				Quoted(debugText, debugLen);
+			else
+				Int(debug);
+			Raw(",\"globaldata\":");
+			Quoted(globalData);
+			Raw(",\"response\":{\"action\":");
+			Int(action);
+			Raw(",\"tauntText\":");
+			Quoted(tauntText);
+			Raw("}}\n");
+			return p - &buf[0];
+		}
+
+		const char *Buffer() const
+		{
+			return &buf[0];
+		}
+
+		// 输出到标准输出；之前经 stdio/iostream 输出的调试信息会先被冲刷
+		void Flush(size_t len) const
+		{
+			cout.flush();
+			fflush(stdout);
+			const char *q = &buf[0];
+#ifdef _WIN32
+			fwrite(q, 1, len, stdout);
+			fflush(stdout);
+#else
+			while (len)
+			{
+				ssize_t n = write(1, q, len);
+				if (n <= 0)
+					break;
+				q += n;
+				len -= n;
+			}
+#endif
+		}
+
+	private:
+		std::vector<char> buf;
+		char *p;
+
+		inline void Raw(const char *s)
+		{
+			while (*s)
+				*p++ = *s++;
+		}
+
+		inline void Int(int x)
+		{
+			char tmp[12];
+			int len = 0;
+			unsigned int u = x < 0 ? 0u - x : x;
+			if (x < 0)
+				*p++ = '-';
+			do
+				tmp[len++] = '0' + u % 10;
+			while (u /= 10);
+			while (len)
+				*p++ = tmp[--len];
+		}
+
+		// 需要转义的字符：0 表示原样输出，否则为转义后 '\\' 之后的字符（'u' 表示 \u00XX）
+		static const char *EscapeTable()
+		{
+			static char table[256];
+			static bool ready = false;
+			if (!ready)
+			{
+				for (int c = 0; c < 0x20; c++)
+					table[c] = 'u';
+				table['"'] = '"';
+				table['\\'] = '\\';
+				table['\b'] = 'b';
+				table['\f'] = 'f';
+				table['\n'] = 'n';
+				table['\r'] = 'r';
+				table['\t'] = 't';
+				ready = true;
+			}
+			return table;
+		}
+
+		inline void Quoted(const string &s)
+		{
+			Quoted(s.data(), s.size());
+		}
+
+		void Quoted(const char *s, size_t len)
+		{
+			static const char hex[] = "0123456789ABCDEF";
+			const char *escape = EscapeTable();
+			const unsigned char *q = (const unsigned char *)s, *end = q + len;
+			*p++ = '"';
+			while (q != end)
+			{
+				// 成段复制不需要转义的字符
+				const unsigned char *begin = q;
+				while (q != end && !escape[*q])
+					q++;
+				memcpy(p, begin, q - begin);
+				p += q - begin;
+				if (q == end)
+					break;
+
+				char e = escape[*q];
+				*p++ = '\\';
+				*p++ = e;
+				if (e == 'u')
+				{
+					*p++ = '0';
+					*p++ = '0';
+					*p++ = hex[*q >> 4];
+					*p++ = hex[*q & 15];
+				}
+				q++;
+			}
+			*p++ = '"';
+		}
+	};
+
 	// 游戏主要逻辑处理类，包括输入输出、回合演算、状态转移，全局唯一 
 	class GameField
 	{
@@ -238,14 +808,29 @@ namespace Pacman
 		int turnID;
 		FieldProp generators[MAX_GENERATOR_COUNT]; // 有哪些豆子产生器
 		Player players[MAX_PLAYER_COUNT]; // 有哪些玩家
+		NewFruits newFruits[MAX_TURN]; // 每次产生的豆子（栈），恢复状态时收回
+		int newFruitsCount;
 
 										  // 玩家选定的动作
 		Direction actions[MAX_PLAYER_COUNT];
 
+		// 针对具体场地尺寸特化的演算函数，由 ReadInput 根据场地尺寸选定
+		bool (GameField::*popStateImpl)();
+		bool (GameField::*nextTurnImpl)();
+
 		// 恢复到上次场地状态。可以一路恢复到最开始。
 		// 恢复失败（没有状态可恢复）返回false
-		bool PopState()
+		inline bool PopState()
+		{
+			return (this->*popStateImpl)();
+		}
+
+		// H、W 为编译期已知的场地尺寸（为 0 则使用运行时的 height/width），取余运算因此可以被常量折叠
+		template<int H, int W>
+		bool PopStateT()
 		{
+			const int height = H ? H : this->height, width = W ? W : this->width;
+
 			if (turnID <= 0)
 				return false;
 
@@ -334,11 +919,80 @@ namespace Pacman
 				!(fieldStatic[p.row][p.col] & direction2OpposingWall[dir]);
 		}
 
+		// 演算的第 2 步：移动之后同一格上的玩家互殴
+		// 按格子编号一次性分组，每个格子只结算一次：力量最大的玩家（可能不止一个）平分其余玩家掉落的一半力量
+		inline void SettleFights(TurnStateTransfer &bt)
+		{
+			int _, i;
+			int cell[MAX_PLAYER_COUNT];
+			for (_ = 0; _ < MAX_PLAYER_COUNT; _++)
+				cell[_] = players[_].dead ? -1 - _ : players[_].row * FIELD_MAX_WIDTH + players[_].col;
+
+			for (_ = 0; _ < MAX_PLAYER_COUNT; _++)
+			{
+				if (cell[_] < 0)
+					continue;
+
+				// 由格子上编号最小的玩家负责结算
+				int same[MAX_PLAYER_COUNT], containedCount = 0, maxStrength = 0;
+				for (i = 0; i < MAX_PLAYER_COUNT; i++)
+				{
+					same[i] = cell[i] == cell[_];
+					containedCount += same[i];
+					maxStrength = std::max(maxStrength, same[i] * players[i].strength);
+				}
+				for (i = 0; i < _; i++)
+					if (same[i])
+						containedCount = 0;
+				if (containedCount <= 1)
+					continue;
+
+				// 不是最强的玩家将会被杀死
+				int lootedStrength = 0, winnerCount = 0, lose[MAX_PLAYER_COUNT];
+				for (i = 0; i < MAX_PLAYER_COUNT; i++)
+				{
+					lose[i] = same[i] & (players[i].strength < maxStrength);
+					winnerCount += same[i] & !lose[i];
+					lootedStrength += lose[i] * (players[i].strength / 2);
+				}
+
+				// 分配给其他玩家
+				int inc = lootedStrength / winnerCount;
+				for (i = 0; i < MAX_PLAYER_COUNT; i++)
+					if (lose[i])
+					{
+						Player &p = players[i];
+
+						// 从格子上移走
+						fieldContent[p.row][p.col] &= ~playerID2Mask[i];
+						p.dead = true;
+						int drop = p.strength / 2;
+						bt.strengthDelta[i] += -drop;
+						bt.change[i] |= TurnStateTransfer::die;
+						p.strength -= drop;
+						aliveCount--;
+					}
+					else if (same[i])
+					{
+						bt.strengthDelta[i] += inc;
+						players[i].strength += inc;
+					}
+			}
+		}
+
 		// 在向actions写入玩家动作后，演算下一回合局面，并记录之前所有的场地状态，可供日后恢复。
 		// 是终局的话就返回false
-		bool NextTurn()
+		inline bool NextTurn()
+		{
+			return (this->*nextTurnImpl)();
+		}
+
+		template<int H, int W>
+		bool NextTurnT()
 		{
-			int _, i, j;
+			ProfileCount(PC_NEXTTURN);
+			const int height = H ? H : this->height, width = W ? W : this->width;
+			int _, i;
 
 			TurnStateTransfer &bt = backtrack[turnID];
 			memset(&bt, 0, sizeof(bt));
@@ -394,61 +1048,7 @@ namespace Pacman
 			}
 
 			// 2. 玩家互殴
-			for (_ = 0; _ < MAX_PLAYER_COUNT; _++)
-			{
-				Player &_p = players[_];
-				if (_p.dead)
-					continue;
-
-				// 判断是否有玩家在一起
-				int player, containedCount = 0;
-				int containedPlayers[MAX_PLAYER_COUNT];
-				for (player = 0; player < MAX_PLAYER_COUNT; player++)
-					if (fieldContent[_p.row][_p.col] & playerID2Mask[player])
-						containedPlayers[containedCount++] = player;
-
-				if (containedCount > 1)
-				{
-					// NAIVE
-					for (i = 0; i < containedCount; i++)
-						for (j = 0; j < containedCount - i - 1; j++)
-							if (players[containedPlayers[j]].strength < players[containedPlayers[j + 1]].strength)
-								swap(containedPlayers[j], containedPlayers[j + 1]);
-
-					int begin;
-					for (begin = 1; begin < containedCount; begin++)
-						if (players[containedPlayers[begin - 1]].strength > players[containedPlayers[begin]].strength)
-							break;
-
-					// 这些玩家将会被杀死
-					int lootedStrength = 0;
-					for (i = begin; i < containedCount; i++)
-					{
-						int id = containedPlayers[i];
-						Player &p = players[id];
-
-						// 从格子上移走
-						fieldContent[p.row][p.col] &= ~playerID2Mask[id];
-						p.dead = true;
-						int drop = p.strength / 2;
-						bt.strengthDelta[id] += -drop;
-						bt.change[id] |= TurnStateTransfer::die;
-						lootedStrength += drop;
-						p.strength -= drop;
-						aliveCount--;
-					}
-
-					// 分配给其他玩家
-					int inc = lootedStrength / begin;
-					for (i = 0; i < begin; i++)
-					{
-						int id = containedPlayers[i];
-						Player &p = players[id];
-						bt.strengthDelta[id] += inc;
-						p.strength += inc;
-					}
-				}
-			}
+			SettleFights(bt);
 
 			// 2.5 金光法器
 			for (_ = 0; _ < MAX_PLAYER_COUNT; _++)
@@ -643,6 +1243,39 @@ namespace Pacman
 				while (getline(cin, chunk) && chunk != "")
 					str += chunk;
 #endif
+			// 先尝试快速解析
+			static RequestReader fast;
+			if (fast.Parse(str.c_str()))
+			{
+				height = fast.height;
+				width = fast.width;
+				LARGE_FRUIT_DURATION = fast.LARGE_FRUIT_DURATION;
+				LARGE_FRUIT_ENHANCEMENT = fast.LARGE_FRUIT_ENHANCEMENT;
+				SKILL_COST = fast.SKILL_COST;
+				generatorTurnLeft = GENERATOR_INTERVAL = fast.GENERATOR_INTERVAL;
+
+				SelectSimulator();
+				PrepareInitialField(fast.staticField, fast.contentField);
+
+				// 根据历史恢复局面
+				for (int i = 1; i < fast.requestCount; i++)
+				{
+					for (int _ = 0; _ < MAX_PLAYER_COUNT; _++)
+						if (!players[_].dead)
+							actions[_] = (Direction)fast.actions[i][_];
+					NextTurn();
+				}
+
+				obtainedData.swap(fast.data);
+				obtainedGlobalData.swap(fast.globalData);
+
+				return fast.id;
+			}
+
+			// 不认识的输入交给 jsoncpp，整棵树从 arena 中分配，函数返回时一次释放
+			static Json::Arena arena(256 * 1024);
+			arena.reset();
+			Json::Arena::Scope scope(arena);
 			Json::Reader reader;
 			Json::Value input;
 			reader.parse(str, input);
@@ -660,6 +1293,7 @@ namespace Pacman
 			SKILL_COST = field["SKILL_COST"].asInt();
 			generatorTurnLeft = GENERATOR_INTERVAL = field["GENERATOR_INTERVAL"].asInt();
 
+			SelectSimulator();
 			PrepareInitialField(staticField, contentField);
 
 			// 根据历史恢复局面
@@ -678,19 +1312,47 @@ namespace Pacman
 			return field["id"].asInt();
 		}
 
+		// 根据当前 height/width 选用特化的演算函数，不在 PACMAN_BOARD_SIZES 中的尺寸走通用版本
+		void SelectSimulator()
+		{
+			popStateImpl = &GameField::PopStateT<0, 0>;
+			nextTurnImpl = &GameField::NextTurnT<0, 0>;
+#define PACMAN_SELECT_SIMULATOR(H, W) \
+			if (height == H && width == W) \
+			{ \
+				popStateImpl = &GameField::PopStateT<H, W>; \
+				nextTurnImpl = &GameField::NextTurnT<H, W>; \
+			}
+			PACMAN_BOARD_SIZES(PACMAN_SELECT_SIMULATOR)
+#undef PACMAN_SELECT_SIMULATOR
+		}
+
 		// 根据 static 和 content 数组准备场地的初始状况
 		void PrepareInitialField(const Json::Value &staticField, const Json::Value &contentField)
+		{
+			int s[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH], t[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
+			for (int r = 0; r < height; r++)
+				for (int c = 0; c < width; c++)
+				{
+					s[r][c] = staticField[r][c].asInt();
+					t[r][c] = contentField[r][c].asInt();
+				}
+			PrepareInitialField(s, t);
+		}
+
+		void PrepareInitialField(const int staticField[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH], const int contentField[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH])
 		{
 			int r, c, gid = 0;
 			generatorCount = 0;
 			aliveCount = 0;
 			smallFruitCount = 0;
+			newFruitsCount = 0;
 			generatorTurnLeft = GENERATOR_INTERVAL;
 			for (r = 0; r < height; r++)
 				for (c = 0; c < width; c++)
 				{
-					GridContentType &content = fieldContent[r][c] = (GridContentType)contentField[r][c].asInt();
-					GridStaticType &s = fieldStatic[r][c] = (GridStaticType)staticField[r][c].asInt();
+					GridContentType &content = fieldContent[r][c] = (GridContentType)contentField[r][c];
+					GridStaticType &s = fieldStatic[r][c] = (GridStaticType)staticField[r][c];
 					if (s & generator)
 					{
 						generators[gid].row = r;
@@ -718,21 +1380,12 @@ namespace Pacman
 		// tauntText 表示想要叫嚣的言语，可以是任意字符串，除了显示在屏幕上不会有任何作用，留空表示不叫嚣
 		// data 表示自己想存储供下一回合使用的数据，留空表示删除
 		// globalData 表示自己想存储供以后使用的数据（替换），这个数据可以跨对局使用，会一直绑定在这个 Bot 上，留空表示删除
-		void WriteOutput(Direction action, string tauntText = "", string data = "", string globalData = "") const
+		// debugText 不为 NULL 时作为 debug 字段输出，否则输出随机种子
+		void WriteOutput(Direction action, const string &tauntText = "", const string &data = "", const string &globalData = "",
+			const char *debugText = NULL, size_t debugLen = 0) const
 		{
-			Json::Value ret;
-			ret["response"]["action"] = action;
-			ret["response"]["tauntText"] = tauntText;
-			ret["data"] = data;
-			ret["globaldata"] = globalData;
-			ret["debug"] = (Json::Int)seed;
-
-#ifdef _BOTZONE_ONLINE
-			Json::FastWriter writer; // 在线评测的话能用就行……
-#else
-			Json::StyledWriter writer; // 本地调试这样好看 > <
-#endif
-			cout << writer.write(ret) << endl;
+			static ResponseWriter writer;
+			writer.Flush(writer.Format(action, tauntText, data, globalData, (int)seed, debugText, debugLen));
 		}
 
 		// 用于显示当前游戏状态，调试用。
@@ -817,16 +1470,24 @@ namespace Pacman
 		}
 
 		// 初始化游戏管理器
+		// 作为库使用时（_PACMAN_LIBRARY）允许多个对象和复制，比如裁判和 Bot 各持一份局面
 		GameField()
 		{
+#ifndef _PACMAN_LIBRARY
 			if (constructed)
 				throw runtime_error("请不要再创建 GameField 对象了，整个程序中只应该有一个对象");
 			constructed = true;
+#endif
 
 			turnID = 0;
+			newFruitsCount = 0;
+			height = width = 0; // 尺寸读入之前先用通用版本
+			SelectSimulator();
 		}
 
+#ifndef _PACMAN_LIBRARY
 		GameField(const GameField &b) : GameField() { }
+#endif
 	};
 
 	bool GameField::constructed = false;
@@ -864,27 +1525,82 @@ inline Pacman::Direction v(int a)
 }
 
 
-//字符串流输出
-inline void Di(int a)
+//调试日志：追加到预先分配的缓冲区，每项之后跟一个空格，Dn() 换行；写满 LOG_CAPACITY 后丢弃后面的内容
+//回合结束时随回复的 debug 字段输出，编译时定义 _PACMAN_NO_LOG 则全部成为空操作
+#define LOG_CAPACITY 4096
+
+struct DebugLog
 {
-	std::stringstream ss;
-	ss << a;
-	string t;
-	ss >> t;
-	ss.clear();
-	globalData += t + ' ';
-}
-inline void Dd(double a)
+	char buf[LOG_CAPACITY]; int len; bool full;
+	
+	inline bool Reserve(int n)
+	{
+		if (len + n > LOG_CAPACITY) full = true;
+		return !full;
+	}
+	inline void Char(char c){if (Reserve(1)) buf[len++] = c;}
+	inline void Text(const char *s, int n){if (Reserve(n+1)) memcpy(buf+len, s, n), len += n, buf[len++] = ' ';}
+	inline void Int(long long a)
+	{
+		char t[24]; int n = 0; unsigned long long u = a < 0 ? 0ull - a : a;
+		do t[n++] = '0' + u % 10; while (u /= 10);
+		if (a < 0) t[n++] = '-';
+		if (!Reserve(n+1)) return;
+		while (n) buf[len++] = t[--n];
+		buf[len++] = ' ';
+	}
+	// 定点输出，保留 4 位小数并去掉末尾的 0；太大的数、inf、nan 交给 snprintf
+	inline void Double(double a)
+	{
+		if (!(a > -1e15 && a < 1e15))
+		{
+			char t[32]; int n = snprintf(t, sizeof(t), "%g", a);
+			Text(t, n); return;
+		}
+		long long x = (long long)(std::fabs(a) * 10000 + 0.5), ip = x / 10000; int fp = x % 10000, n = 0;
+		char t[32];
+		if (a < 0 && x) t[n++] = '-';
+		char d[24]; int m = 0;
+		do d[m++] = '0' + ip % 10; while (ip /= 10);
+		while (m) t[n++] = d[--m];
+		if (fp)
+		{
+			t[n++] = '.';
+			for (int k = 1000; fp; k /= 10) t[n++] = '0' + fp / k, fp %= k;
+		}
+		Text(t, n);
+	}
+} Log;
+
+#ifndef _PACMAN_NO_LOG
+inline void Di(long long a){Log.Int(a);}
+inline void Dd(double a){Log.Double(a);}
+inline void Ds(const char *a){Log.Text(a, strlen(a));}
+inline void Dn(){Log.Char('\n');}
+#else
+inline void Di(long long){}
+inline void Dd(double){}
+inline void Ds(const char *){}
+inline void Dn(){}
+#endif
+
+// 把本回合的剖析记录追加到 out：一行各阶段耗时与总耗时（微秒，round 后依次是每轮），一行计数器
+void WriteProfile(DebugLog &out)
 {
-	std::stringstream ss;
-	ss << a;
-	string t;
-	ss >> t;
-	ss.clear();
-	globalData += t + ' ';
+	static const char *names[PF_COUNT] = {"read", "data", "dis", "death", "wall", "candy", "round", 0, 0, 0, 0, 0, 0, 0, "fight", "final", "write"};
+	int lastRound = PF_ROUND;
+	rep(p, PF_ROUND, PF_FIGHT-1) if (Profile.phase[p]) lastRound = p;
+	out.Text("prof", 4);
+	rep(p, 0, PF_COUNT-1) if (p <= lastRound || p >= PF_FIGHT)
+	{
+		if (names[p]) out.Text(names[p], strlen(names[p]));
+		out.Int(Profile.phase[p]);
+	}
+	out.Text("total", 5), out.Int(Profile.Since(Profile.start)), out.Char('\n');
+	out.Text("rollout", 7), out.Int(Profile.counter[PC_ROLLOUT]);
+	out.Text("nextturn", 8), out.Int(Profile.counter[PC_NEXTTURN]);
+	out.Text("bfs", 3), out.Int(Profile.counter[PC_BFS]), out.Char('\n');
 }
-inline void Ds(string a){globalData += a + ' ';}
-inline void Dn(){globalData += '\n';}
 
 
 struct Pro {double d[5];} emptyPro;
@@ -900,15 +1616,20 @@ inline double Between(double a, double b, double c)
 	if (a == b) return 0.5;
 	return (erf(((c-a)/(b-a)*2-1)*2)+1)/2;
 }
-inline Pacman::Direction RandDir(Pro a)
+// 随机数为 tmp 时 RandDir 的结果：0~4 对应 v(i-1)，5 表示逐项减完仍未命中（按 v(-1) 处理）
+inline int RandDirIndex(Pro a, double tmp)
 {
 	double All = 0;
 	rep(i, 0, 4) All += a.d[i];
 	rep(i, 0, 4) a.d[i] /= All;
-	double tmp = Rand();
 	
-	rep(i, 0, 4) if (tmp <= a.d[i]) return v(i-1); else tmp -= a.d[i];
-	return v(-1);
+	rep(i, 0, 4) if (tmp <= a.d[i]) return i; else tmp -= a.d[i];
+	return 5;
+}
+inline Pacman::Direction RandDir(Pro a)
+{
+	int i = RandDirIndex(a, Rand());
+	return v(i == 5 ? -1 : i-1);
 }
 inline Pacman::Direction RandDirOne(Pro a)
 {
@@ -931,48 +1652,220 @@ inline Pii GO(Pii a, int d)
 
 int Count[MAX_PLAYER_COUNT][7][6];
 
-struct Req{int a, b, c, d;} Request[10009]; int RequestNum;
+// 预测请求：对手 a 本回合若做出动作 b，则下回合 Count[a][c][d]++
+// 按 (玩家, 情形) 聚合：ReqSlot[a][c][b+1] 是动作 b 对应的计数槽位集，重复的请求自然合并，大小固定不会溢出
+unsigned char ReqSlot[MAX_PLAYER_COUNT][7][9];
 
-Req Addreq(int a, int b, int c, int d){return (Req){a,b,c,d};}
+inline void Addreq(int a, int b, int c, int d){ReqSlot[a][c][b+1] |= 1 << d;}
 
-void DealWithInputData()
+// data 的编码（第 2 版）：
+//   版本号 1 字节；
+//   每个对手 Count 表中用到的 24 项，按 CountCell 的顺序，各为一个 varint；
+//   每个对手 7 位的情形位集，表示哪些 (玩家, 情形) 有预测请求；
+//   每个这样的 (玩家, 情形)：6 位的默认槽位集，9 位的例外动作位集，每个例外动作再跟 6 位的槽位集；
+// 整个位串再用 base64（不补 '='）包装成文本，免去 JSON 的转义
+#define DATA_VERSION 2
+
+const int CountCell[24][2] = {
+	{0,0}, {0,1}, {1,0}, {1,1},
+	{2,0}, {2,1}, {2,2}, {2,3}, {3,0}, {3,1}, {3,2}, {3,3},
+	{4,0}, {4,1}, {5,0}, {5,1}, {6,0}, {6,1},
+	{1,4}, {1,5}, {3,4}, {3,5}, {5,2}, {5,3}
+};
+
+// 对局开始时对手行为的先验，顺序同 CountCell
+const int CountPrior[24] = {1, 0, 0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0};
+
+const char Base64Table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+inline int Base64Value(char c)
 {
-	std::istringstream istr(data);
-	rep(a, 0, 3) if (a != myID)
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+// 直接在 base64 文本上逐字节解码，不申请内存
+struct DataReader
+{
+	const char *p, *end; unsigned int acc; int bits; bool bad;
+	
+	DataReader(const string &s) : p(s.data()), end(s.data()+s.size()), acc(0), bits(0), bad(false) {}
+	
+	inline int Bits(int n)
+	{
+		while (bits < n)
+		{
+			int v = p == end ? -1 : Base64Value(*p++);
+			if (v < 0) {bad = true; return 0;}
+			acc = (acc << 6 | v) & 0xFFFFFF, bits += 6;
+		}
+		bits -= n;
+		return acc >> bits & ((1 << n) - 1);
+	}
+	inline int Byte(){return Bits(8);}
+	inline unsigned int Varint()
 	{
-		rep(i, 0, 1) rep(j, 0, 1) istr >> Count[a][i][j];
-		rep(i, 2, 3) rep(j, 0, 3) istr >> Count[a][i][j];
-		rep(i, 4, 6) rep(j, 0, 1) istr >> Count[a][i][j];
-		rep(j, 4, 5) istr >> Count[a][1][j];
-		rep(j, 4, 5) istr >> Count[a][3][j];
-		rep(j, 2, 3) istr >> Count[a][5][j];
+		unsigned int x = 0;
+		for (int shift = 0; shift < 35 && !bad; shift += 7)
+		{
+			int c = Byte(); x |= (unsigned int)(c & 127) << shift;
+			if (!(c & 128)) return x;
+		}
+		bad = true; return 0;
 	}
-	int n, a, b, c, d; istr >> n; if (!n) return;
+};
+
+struct DataWriter
+{
+	unsigned char buf[32 + MAX_PLAYER_COUNT*24*5 + MAX_PLAYER_COUNT*7*9]; int len; unsigned int acc; int bits;
 	
-	const Pacman::TurnStateTransfer &bt = gameField.backtrack[gameField.turnID-1];
-	rep(i, 1, n)
+	DataWriter() : len(0), acc(0), bits(0) {}
+	
+	inline void Bits(int x, int n)
+	{
+		acc = acc << n | x, bits += n;
+		while (bits >= 8) bits -= 8, buf[len++] = acc >> bits & 255;
+	}
+	inline void Byte(int c){Bits(c, 8);}
+	inline void Varint(unsigned int x)
 	{
-		istr >> a >> b >> c >> d;
-		if (bt.actions[a] == b) Count[a][c][d]++;
+		while (x >= 128) Byte((x & 127) | 128), x >>= 7;
+		Byte(x);
+	}
+	void Armour(string &out)
+	{
+		if (bits) Bits(0, 8-bits);
+		out.clear(); out.reserve((len*4+2)/3);
+		int i = 0;
+		for (; i+2 < len; i += 3)
+		{
+			unsigned int v = buf[i] << 16 | buf[i+1] << 8 | buf[i+2];
+			out += Base64Table[v >> 18], out += Base64Table[v >> 12 & 63], out += Base64Table[v >> 6 & 63], out += Base64Table[v & 63];
+		}
+		if (len - i == 1) out += Base64Table[buf[i] >> 2], out += Base64Table[(buf[i] & 3) << 4];
+		if (len - i == 2) out += Base64Table[buf[i] >> 2], out += Base64Table[(buf[i] & 3) << 4 | buf[i+1] >> 4], out += Base64Table[(buf[i+1] & 15) << 2];
+	}
+};
+
+// globalData：跨对局保存的对手行为统计（第 1 版），编码方式同 data
+//   版本号 1 字节，已统计的对局数 varint；
+//   GlobalBase：以前各局学到的统计，每开一局衰减为 GLOBAL_DECAY 倍（向下取整，很久以前的统计最终会归零），24 项定点数（x16）varint；
+//   GlobalCurrent：本局到目前为止学到的统计，即各对手 Count 相对开局时的平均增量，24 项定点数（x16）varint；
+// 平台不告诉我们对手是哪个 Bot，所以统计的是遇到过的对手的总体行为，大小固定
+#define GLOBAL_VERSION 1
+#define GLOBAL_DECAY 0.9
+#define GLOBAL_WEIGHT 6 // 每个情形的两个计数槽合起来最多相当于这么多次观察
+#define GLOBAL_LIMIT (1<<20)
+
+int GlobalMatches, GlobalBase[24], GlobalCurrent[24], CountWarm[24];
+
+void LoadGlobalData()
+{
+	GlobalMatches = 0; clr(GlobalBase, 0); clr(GlobalCurrent, 0);
+	if (!globalData.empty())
+	{
+		DataReader in(globalData);
+		if (in.Byte() == GLOBAL_VERSION)
+		{
+			GlobalMatches = in.Varint();
+			rep(k, 0, 23) GlobalBase[k] = std::min((int)in.Varint(), GLOBAL_LIMIT);
+			rep(k, 0, 23) GlobalCurrent[k] = std::min((int)in.Varint(), GLOBAL_LIMIT);
+			if (in.bad) GlobalMatches = 0, clr(GlobalBase, 0), clr(GlobalCurrent, 0);
+		}
+	}
+	
+	// 新的一局：并入上一局的统计
+	if (gameField.turnID == 0)
+	{
+		rep(k, 0, 23) GlobalBase[k] = std::min((int)(GlobalBase[k] * GLOBAL_DECAY) + GlobalCurrent[k], GLOBAL_LIMIT), GlobalCurrent[k] = 0;
+		GlobalMatches++;
+	}
+	
+	// 开局时的计数：先验加上按权重压缩过的历史统计，CountCell 中相邻两项是同一情形的两个计数槽
+	rep(k, 0, 23)
+	{
+		double all = (GlobalBase[k] + GlobalBase[k^1]) / 16.0, scale = all > GLOBAL_WEIGHT ? GLOBAL_WEIGHT / all : 1;
+		CountWarm[k] = CountPrior[k] + (int)(GlobalBase[k] / 16.0 * scale + 0.5);
+	}
+}
+
+void SaveGlobalData()
+{
+	static DataWriter out; out.len = out.bits = 0;
+	out.Byte(GLOBAL_VERSION);
+	out.Varint(GlobalMatches);
+	rep(k, 0, 23) out.Varint(GlobalBase[k]);
+	rep(k, 0, 23)
+	{
+		int sum = 0, n = 0;
+		rep(a, 0, 3) if (a != myID) sum += std::max(Count[a][CountCell[k][0]][CountCell[k][1]] - CountWarm[k], 0), n++;
+		out.Varint(std::min(sum * 16 / n, GLOBAL_LIMIT));
+	}
+	out.Armour(globalData);
+}
+
+inline void CountInitPrior()
+{
+	rep(a, 0, 3) if (a != myID) rep(k, 0, 23) Count[a][CountCell[k][0]][CountCell[k][1]] = CountWarm[k];
+}
+
+void DealWithInputData()
+{
+	if (data.empty()) {CountInitPrior(); return;}
+	
+	DataReader in(data);
+	if (in.Byte() != DATA_VERSION) {CountInitPrior(); return;}
+	rep(a, 0, 3) if (a != myID) rep(k, 0, 23) Count[a][CountCell[k][0]][CountCell[k][1]] = in.Varint();
+	if (in.bad) {CountInitPrior(); return;}
+	
+	int situation[MAX_PLAYER_COUNT];
+	rep(a, 0, 3) if (a != myID) situation[a] = in.Bits(7);
+	rep(a, 0, 3) if (a != myID) rep(c, 0, 6) if (situation[a] >> c & 1)
+	{
+		int dflt = in.Bits(6), except = in.Bits(9), slot = dflt;
+		rep(b, -1, 7) if (except >> (b+1) & 1)
+		{
+			int tmp = in.Bits(6);
+			if (b == gameField.backtrack[gameField.turnID-1].actions[a]) slot = tmp;
+		}
+		if (in.bad) return;
+		rep(d, 0, 5) if (slot >> d & 1) Count[a][c][d]++;
 	}
 }
 
 void DealWithOutputData()
 {
-	std::ostringstream ostr;
+	static DataWriter out; out.len = out.bits = 0;
+	out.Byte(DATA_VERSION);
+	rep(a, 0, 3) if (a != myID) rep(k, 0, 23) out.Varint(Count[a][CountCell[k][0]][CountCell[k][1]]);
 	rep(a, 0, 3) if (a != myID)
 	{
-		rep(i, 0, 1) rep(j, 0, 1) ostr << Count[a][i][j] << ' ';
-		rep(i, 2, 3) rep(j, 0, 3) ostr << Count[a][i][j] << ' ';
-		rep(i, 4, 6) rep(j, 0, 1) ostr << Count[a][i][j] << ' ';
-		rep(j, 4, 5) ostr << Count[a][1][j] << ' ';
-		rep(j, 4, 5) ostr << Count[a][3][j] << ' ';
-		rep(j, 2, 3) ostr << Count[a][5][j] << ' ';
-		ostr << '\n';
-	}
-	ostr << RequestNum << ' ' << '\n';
-	rep(i, 1, RequestNum) ostr << Request[i].a << ' ' << Request[i].b << ' ' << Request[i].c << ' ' << Request[i].d << ' ' << '\n';
-	data = ostr.str();
+		int situation = 0;
+		rep(c, 0, 6) rep(b, 0, 8) if (ReqSlot[a][c][b]) situation |= 1 << c;
+		out.Bits(situation, 7);
+	}
+	rep(a, 0, 3) if (a != myID) rep(c, 0, 6)
+	{
+		unsigned char *slot = ReqSlot[a][c];
+		int dflt = -1, best = 0;
+		rep(b, 0, 8)
+		{
+			int same = 0;
+			rep(k, 0, 8) same += slot[k] == slot[b];
+			if (same > best) best = same, dflt = slot[b];
+		}
+		if (!dflt && best == 9) continue;
+		
+		int except = 0;
+		rep(b, 0, 8) if (slot[b] != dflt) except |= 1 << b;
+		out.Bits(dflt, 6), out.Bits(except, 9);
+		rep(b, 0, 8) if (slot[b] != dflt) out.Bits(slot[b], 6);
+	}
+	out.Armour(data);
 }
 
 
@@ -1014,7 +1907,7 @@ inline void DeathPlace()
 		bool fg = true;
 		while (!q1.empty())
 		{
-			Pii a = q1.front(); q1.pop(); int tmp = 0;
+			Pii a = q1.front(); q1.pop(); int tmp = 0; ProfileCount(PC_BFS);
 			rep(d, 0, 3) if (gameField.fieldStatic[a.fi][a.se] & (1<<d)) continue; else
 			{
 				a = GO(a, d);
@@ -1040,7 +1933,7 @@ inline void DeathPlace()
 	int tmp = 0;
 	while (!q2.empty())
 	{
-		Pii a = q2.front(); q2.pop(); Pii b = a;
+		Pii a = q2.front(); q2.pop(); Pii b = a; ProfileCount(PC_BFS);
 		rep(d, 0, 3) if (gameField.fieldStatic[a.fi][a.se] & (1<<d)) continue; else
 		{
 			a = GO(a, d); if (lb[a.fi][a.se] == 3)
@@ -1057,7 +1950,7 @@ inline void DeathPlace()
 	}
 	while (!q1.empty())
 	{
-		Pii a = q1.front(); q1.pop(); Pii tmp = DeathMap[a.fi][a.se]; Pii b = Control[a.fi][a.se];
+		Pii a = q1.front(); q1.pop(); Pii tmp = DeathMap[a.fi][a.se]; Pii b = Control[a.fi][a.se]; ProfileCount(PC_BFS);
 		rep(d, 0, 3) if (gameField.fieldStatic[a.fi][a.se] & (1<<d)) continue; else
 		{
 			a = GO(a, d); if (lb[a.fi][a.se] == 3 && DeathMap[a.fi][a.se].fi == 0)
@@ -1086,7 +1979,7 @@ inline void WallMap()
 		q.push(Pii(gameField.players[i].row,gameField.players[i].col)), Short[gameField.players[i].row][gameField.players[i].col] = 0;
 	while (!q.empty())
 	{
-		Pii a = q.front(); q.pop(); int v = Short[a.fi][a.se];
+		Pii a = q.front(); q.pop(); int v = Short[a.fi][a.se]; ProfileCount(PC_BFS);
 		rep(d, 0, 3) if ((gameField.fieldStatic[a.fi][a.se] & (1<<d)) == 0) 
 		{
 			a = GO(a, d); 
@@ -1102,7 +1995,7 @@ inline void WallMap()
 		q.push(Pii(gameField.players[i].row,gameField.players[i].col)), Short[gameField.players[i].row][gameField.players[i].col] = 0;
 	while (!q.empty())
 	{
-		Pii a = q.front(); q.pop(); int v = Short[a.fi][a.se];
+		Pii a = q.front(); q.pop(); int v = Short[a.fi][a.se]; ProfileCount(PC_BFS);
 		rep(d, 0, 3) if ((gameField.fieldStatic[a.fi][a.se] & (1<<d)) == 0) 
 		{
 			a = GO(a, d); 
@@ -1115,7 +2008,7 @@ inline void WallMap()
 		q.push(Pii(i,j)), Wall[i][j].fi = 0;
 	while (!q.empty())
 	{
-		Pii a = q.front(); q.pop(); int v = Wall[a.fi][a.se].fi;
+		Pii a = q.front(); q.pop(); int v = Wall[a.fi][a.se].fi; ProfileCount(PC_BFS);
 		rep(d, 0, 3) if ((gameField.fieldStatic[a.fi][a.se] & (1<<d)) == 0) 
 		{
 			a = GO(a, d); 
@@ -1170,7 +2063,7 @@ inline void Candy()
 		q.push(Pii(gameField.players[o].row,gameField.players[o].col)), lb[gameField.players[o].row][gameField.players[o].col] = 0;
 		while (!q.empty())
 		{
-			Pii a = q.front(); q.pop(); int v = lb[a.fi][a.se];
+			Pii a = q.front(); q.pop(); int v = lb[a.fi][a.se]; ProfileCount(PC_BFS);
 			if (v == 0) FirstRoundMap[a.fi][a.se] -= 20;
 			if (v == 1) {FirstRoundMap[a.fi][a.se] -= 15; continue;}
 			rep(d, 0, 3) if ((gameField.fieldStatic[a.fi][a.se] & (1<<d)) == 0) 
@@ -1219,7 +2112,10 @@ inline void Candy()
 
 // Monte Carlo Search
 
-#define MAX_SEARCH 7
+#define opp_A 5
+#define opp_E 8 // 离所有对手都足够远时，最后一次搜索的步数；设为 opp_A 即关闭
+#define MAX_SEARCH ((opp_A > opp_E ? opp_A : opp_E) + 1) // 路线最多存的步数（含出发点），随各轮和最后一次搜索中最深的步数而定
+#define DANGER_FADE 7 // 第 L 步遇到对手的分数乘 log(DANGER_FADE-L)，从第 DANGER_FADE-1 步起不再计
 
 double ppow[59], ppow2[59], ppow3[59];
 	
@@ -1231,11 +2127,11 @@ int page = 0, WayCount;
 
 Pro PlayerPro[MAX_PLAYER_COUNT];
 
-Pii BeanNow[409], BeanWill[409]; int Bean1, Bean2;
+Pii BeanNow[409], BeanWill[409]; int Bean1, Bean2; bool BeanHere[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
 
 inline void BeanScoreInit()
 {
-	rep(i, 0, h-1) rep(j, 0, w-1) if (gameField.fieldContent[i][j] & (16+32)) BeanNow[++Bean1] = Pii(i,j);
+	rep(i, 0, h-1) rep(j, 0, w-1) if (gameField.fieldContent[i][j] & (16+32)) BeanNow[++Bean1] = Pii(i,j), BeanHere[i][j] = 1;
 	
 	bool lb[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH]; clr(lb,0);
 	rep(a, 0, h-1) rep(b, 0, w-1) if (gameField.fieldStatic[a][b] & 16) rep(c, -1, 1) rep(d, -1, 1) if (c!=0 || d!=0)
@@ -1243,51 +2139,162 @@ inline void BeanScoreInit()
 	rep(i, 0, h-1) rep(j, 0, w-1) if (lb[i][j]) BeanWill[++Bean2] = Pii(i,j);
 }
 
-inline double BeanScore(int x0, int y0, int x1, int y1, int R)
+// 从 (x0, y0) 走到 (x1, y1) 时 (x, y) 处的豆子带来的分数，R 是已走的步数
+inline double BeanGain(int x, int y, int x0, int y0, int x1, int y1, int R)
+{
+	double d = 1;
+	rep(i, 0, 3) d *= 1 - eat[page^1][x][y][i][R+Dis[x][y][x0][y0]];
+	return (1.0/(Dis[x][y][x1][y1]+1)-1.0/(Dis[x][y][x0][y0]+1)) * d;
+}
+
+// BeanNow 的豆子全都还在时的 BeanScore
+inline double BeanScoreAll(int x0, int y0, int x1, int y1, int R)
 {
 	double Ans = 0;
 	
 	for(int i=1, x=BeanNow[i].fi, y=BeanNow[i].se; i<=Bean1; i++, x=BeanNow[i].fi, y=BeanNow[i].se) 
-		if ((gameField.fieldContent[x][y] & (16+32)) && Dis[x][y][x0][y0] > Dis[x][y][x1][y1])
-		{
-			double d = 1;
-			rep(i, 0, 3) d *= 1 - eat[page^1][x][y][i][R+Dis[x][y][x0][y0]];
-			Ans += (1.0/(Dis[x][y][x1][y1]+1)-1.0/(Dis[x][y][x0][y0]+1)) * d;
-		}
+		if (Dis[x][y][x0][y0] > Dis[x][y][x1][y1])
+			Ans += BeanGain(x, y, x0, y0, x1, y1, R);
 	
 	for(int i=1, x=BeanWill[i].fi, y=BeanWill[i].se; i<=Bean2; i++, x=BeanWill[i].fi, y=BeanWill[i].se) 
 		if (BeginturnID/Interval+1 == (BeginturnID+Dis[x][y][x0][y0])/Interval && Dis[x][y][x0][y0] > Dis[x][y][x1][y1])
+			Ans += BeanGain(x, y, x0, y0, x1, y1, R);
+	
+	return Ans;
+}
+
+// 一轮之内（eat[page^1] 不变）BeanScore 只随模拟中被吃掉的 BeanNow 豆子变化，而只有模拟的玩家在场，被吃掉的豆子都在路线上：
+// 所以按 (出发格, 方向, 步数) 缓存豆子全在时的值，用时只减去路线上已被吃掉的豆子；BeanRound 每轮加一，旧的缓存随之失效
+// 各轮之间不沿用路线本身：几乎每项分数都随 page 变化，重放前缀仍要逐步演算，试过省不下时间
+double BeanMemo[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH][4][MAX_SEARCH];
+unsigned int BeanMemoRound[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH][4][MAX_SEARCH], BeanRound;
+
+struct Way;
+
+// 路线 now 第 L 步（从第 L-1 步的位置走到第 L 步的位置）的 BeanScore，此时 gameField 是走完第 L 步的局面
+inline double BeanScore(const Way &now, int L);
+
+// 路线上的一步：这一步的动作和走完后的位置、力量，共 6 个字节
+struct WayStep
+{
+	unsigned char x, y; signed char act; short strength;
+};
+
+// 一条路线对齐到缓存行（现在的步数下是两行，128 字节）；step[0] 是出发时的位置和力量
+struct alignas(64) Way
+{
+	double score, pos; int length; WayStep step[MAX_SEARCH];
+} Ways[10009];
+
+inline double BeanScore(const Way &now, int L)
+{
+	int x0 = now.step[L-1].x, y0 = now.step[L-1].y, x1 = now.step[L].x, y1 = now.step[L].y, a = now.step[L].act;
+	if (a < 0 || (x0 == x1 && y0 == y1)) return 0; // 原地不动时没有豆子变近
+	
+	if (BeanMemoRound[x0][y0][a][L-1] != BeanRound)
+		BeanMemo[x0][y0][a][L-1] = BeanScoreAll(x0, y0, x1, y1, L-1), BeanMemoRound[x0][y0][a][L-1] = BeanRound;
+	double Ans = BeanMemo[x0][y0][a][L-1];
+	
+	rep(j, 0, L)
+	{
+		int x = now.step[j].x, y = now.step[j].y; bool seen = false;
+		rep(k, 0, j-1) if (now.step[k].x == x && now.step[k].y == y) seen = true;
+		if (!seen && BeanHere[x][y] && !(gameField.fieldContent[x][y] & (16+32)) && Dis[x][y][x0][y0] > Dis[x][y][x1][y1])
+			Ans -= BeanGain(x, y, x0, y0, x1, y1, L-1);
+	}
+	return Ans;
+}
+
+// 模拟中自己每步的动作分布只取决于所在格子四面的墙（即 ActionValid）和上一步的反方向（Pre）：
+// 按 (可走方向的集合, 反方向) 预先算好 RandDir 的判定门限，RollMask 记下每个格子可走方向的集合，
+// 模拟时每步取一个随机整数依次和门限比较即可；门限由 RandDirIndex 二分得到，结果与逐步调用 RandDir 完全一致
+struct RollPolicy
+{
+	unsigned int limit[5]; // 随机整数不超过 limit[i] 时取 v(i-1)，全部超过时取 v(-1)
+} RollTable[16][5];
+
+unsigned char RollMask[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
+
+// 可走方向集合为 mask、反方向为 Back（-1 表示没有）时一步的动作分布
+inline Pro RollPro(int mask, int Back)
+{
+	Pro valid = emptyPro;
+	int vCount = 1;
+	rep(d, 0, 3) if (mask >> d & 1) vCount++;
+	valid.d[0] = 1.0/vCount;
+	rep(d, 0, 3) if (mask >> d & 1) valid.d[d+1] = 1.0/vCount;
+	
+	if (valid.d[0])
+	{
+		rep(d, 0, 3) if (valid.d[d+1]) valid.d[d+1]+=valid.d[0]/10*9/(vCount-1);
+		valid.d[0] /= 10;
+	}
+	if (0<=Back && valid.d[Back+1])
+	{
+		rep(d, -1, 3) if (d!=Back && valid.d[d+1]) valid.d[d+1]+=valid.d[Back+1]/10*9/(vCount-1);
+		valid.d[Back+1] /= 10;
+	}
+	return valid;
+}
+
+inline void RollInit()
+{
+	static bool ready = false;
+	if (!ready)
+	{
+		rep(mask, 0, 15) rep(Back, -1, 3)
 		{
-			double d = 1;
-			rep(i, 0, 3) d *= 1 - eat[page^1][x][y][i][R+Dis[x][y][x0][y0]];
-			Ans += (1.0/(Dis[x][y][x1][y1]+1)-1.0/(Dis[x][y][x0][y0]+1)) * d;
+			RollPolicy &p = RollTable[mask][Back+1];
+			Pro valid = RollPro(mask, Back);
+			// RandDirIndex 随随机数单调不减，二分出每个结果的最大随机整数
+			rep(i, 0, 4)
+			{
+				long long lo = 0, hi = 0xFFFFFFFFll;
+				while (lo < hi)
+				{
+					long long mid = (lo + hi + 1) / 2;
+					if (RandDirIndex(valid, 1.0 * (unsigned int)mid / (long long)0xFFFFFFFF) <= i) lo = mid; else hi = mid - 1;
+				}
+				p.limit[i] = (unsigned int)lo;
+			}
 		}
+		ready = true;
+	}
 	
-	return Ans;
+	rep(x, 0, h-1) rep(y, 0, w-1)
+	{
+		RollMask[x][y] = 0;
+		rep(d, 0, 3) if (!(gameField.fieldStatic[x][y] & Pacman::direction2OpposingWall[d])) RollMask[x][y] |= 1 << d;
+	}
 }
 
-struct Way
+inline Pacman::Direction RollDir(const RollPolicy &p)
 {
-	int length, act[MAX_SEARCH], x[MAX_SEARCH], y[MAX_SEARCH], strength[MAX_SEARCH]; double score, pos;
-} Ways[10009], emptyWay;
+	unsigned int r = RandInt();
+	rep(i, 0, 4) if (r <= p.limit[i]) return v(i-1);
+	return v(-1);
+}
 
 inline int Pre(Way &now, int L)
 {
 	int a;
 	//if (L == 0) a = gameField.backtrack[gameField.turnID-1].actions[PlayerID]; 
 	if (L == 0) a = -1; 
-	else a = now.act[L];
+	else a = now.step[L].act;
 	if (a == -1) return -1;
 	return a^2;
 }
 
-inline void MC(Way &now, int PlayerID, int Round)
+// 单次模拟，第一步固定为 First，H、W 含义同 GameField::NextTurnT
+template<int H, int W>
+void MCT(Way &now, int PlayerID, int Round, Pacman::Direction First)
 {
+	ProfileCount(PC_ROLLOUT);
 	int L = 0;
 	
 	while (true)
 	{
-		if (L == 1 && PlayerID == myID) now.score += FirstRoundMap[now.x[L]][now.y[L]];
+		if (L == 1 && PlayerID == myID) now.score += FirstRoundMap[now.step[L].x][now.step[L].y];
 		
 		if (L == Round || gameField.turnID >= MAX_TURN)
 		{
@@ -1296,78 +2303,67 @@ inline void MC(Way &now, int PlayerID, int Round)
 		
 		rep(i, 0, MAX_PLAYER_COUNT-1) gameField.actions[i] = Pacman::stay;
 		
-		Pro valid = emptyPro;
-		int vCount = 0;
-		for (Pacman::Direction d = Pacman::stay; d < 4; ++d) if (gameField.ActionValid(PlayerID, d)) vCount++;
-		for (Pacman::Direction d = Pacman::stay; d < 4; ++d) if (gameField.ActionValid(PlayerID, d)) valid.d[d+1] = 1.0/vCount;
-		
-		if (valid.d[0])
-		{
-			rep(d, 0, 3) if (valid.d[d+1]) valid.d[d+1]+=valid.d[0]/10*9/(vCount-1);
-			valid.d[0] /= 10;
-		}
-		int Back = Pre(now,L);
-		if (0<=Back && valid.d[Back+1])
-		{
-			rep(d, -1, 3) if (d!=Back && valid.d[d+1]) valid.d[d+1]+=valid.d[Back+1]/10*9/(vCount-1);
-			valid.d[Back+1] /= 10;
-		}
+		const Pacman::Player &me = gameField.players[PlayerID];
+		int mask = RollMask[me.row][me.col], Back = Pre(now,L);
+		const RollPolicy &policy = RollTable[mask][Back+1];
 		
-		if (L == 0)
-		{
-			int a = WayCount % vCount;
-			for (Pacman::Direction d = Pacman::stay; d < 4; ++d) if (gameField.ActionValid(PlayerID, d))
-			{
-				a--;
-				if (a % vCount == 0) 
-				{
-					gameField.actions[PlayerID] = d;
-					break;
-				}
-			}
-		}
-		else gameField.actions[PlayerID] = RandDir(valid);
+		if (L == 0) gameField.actions[PlayerID] = First;
+		else gameField.actions[PlayerID] = RollDir(policy);
 		
-		now.act[++L] = gameField.actions[PlayerID];
+		now.step[++L].act = gameField.actions[PlayerID];
 		
 		double tmp = -gameField.players[PlayerID].strength;
-		gameField.NextTurn();
+		gameField.NextTurnT<H, W>();
 		tmp += gameField.players[PlayerID].strength;
-		now.x[L] = gameField.players[PlayerID].row;
-		now.y[L] = gameField.players[PlayerID].col;
-		now.strength[L] = gameField.players[PlayerID].strength;
+		now.step[L].x = gameField.players[PlayerID].row;
+		now.step[L].y = gameField.players[PlayerID].col;
+		now.step[L].strength = gameField.players[PlayerID].strength;
 		
 		while (tmp < 0) tmp += gameField.LARGE_FRUIT_ENHANCEMENT;
 		if (tmp == gameField.LARGE_FRUIT_ENHANCEMENT) tmp = 1;
 		tmp *= 3;
 		
-		rep(i, 0, 3) if (i != PlayerID && eat[page^1][now.x[L]][now.y[L]][i][L-1] > 0.98) tmp = 0;
+		rep(i, 0, 3) if (i != PlayerID && eat[page^1][now.step[L].x][now.step[L].y][i][L-1] > 0.98) tmp = 0;
 		
 		if (tmp == 0) tmp = -1;
 		now.score += tmp * 1/L;
-		now.score += BeanScore(now.x[L-1],now.y[L-1],now.x[L],now.y[L],L-1) * 1/L;
+		now.score += BeanScore(now, L) * 1/L;
 		
-		double mn = 1e90;
-		rep(i, 0, 3) if (i != PlayerID && Appear[page^1][now.x[L]][now.y[L]][i][L].se + Appear[page^1][now.x[L]][now.y[L]][i][L-1].se > 0)
-			mn = std::min(mn, erf((now.strength[L] - Appear[page^1][now.x[L]][now.y[L]][i][L].fi)/2) * Appear[page^1][now.x[L]][now.y[L]][i][L].se * ppow[L] + erf((now.strength[L] - Appear[page^1][now.x[L]][now.y[L]][i][L-1].fi)/2) * Appear[page^1][now.x[L]][now.y[L]][i][L-1].se * ppow[L-1]);
-		if (mn == 1e90) mn = 0;
-		if (PlayerID == myID)
-			now.score += mn * (mn < 0 ? 2 : 0) * log(MAX_SEARCH-L);
-		else
-			now.score += mn * (mn < 0 ? 5 : 5) * log(MAX_SEARCH-L);
+		if (L < DANGER_FADE-1)
+		{
+			double mn = 1e90;
+			rep(i, 0, 3) if (i != PlayerID && Appear[page^1][now.step[L].x][now.step[L].y][i][L].se + Appear[page^1][now.step[L].x][now.step[L].y][i][L-1].se > 0)
+				mn = std::min(mn, erf((now.step[L].strength - Appear[page^1][now.step[L].x][now.step[L].y][i][L].fi)/2) * Appear[page^1][now.step[L].x][now.step[L].y][i][L].se * ppow[L] + erf((now.step[L].strength - Appear[page^1][now.step[L].x][now.step[L].y][i][L-1].fi)/2) * Appear[page^1][now.step[L].x][now.step[L].y][i][L-1].se * ppow[L-1]);
+			if (mn == 1e90) mn = 0;
+			if (PlayerID == myID)
+				now.score += mn * (mn < 0 ? 2 : 0) * log(DANGER_FADE-L);
+			else
+				now.score += mn * (mn < 0 ? 5 : 5) * log(DANGER_FADE-L);
+		}
 		
-		if (Back>=0 && now.act[L] == Back) 
+		if (Back>=0 && now.step[L].act == Back) 
 			now.score -= 2;
-		if (now.act[L] == -1) now.score -= 0.15;
+		if (now.step[L].act == -1) now.score -= 0.15;
 		
-		if (PlayerID == myID && Wall[now.x[L]][now.y[L]].fi && Wall[now.x[L]][now.y[L]].fi+1-std::max(Wall[now.x[L]][now.y[L]].se-L,0)>=2)
+		if (PlayerID == myID && Wall[now.step[L].x][now.step[L].y].fi && Wall[now.step[L].x][now.step[L].y].fi+1-std::max(Wall[now.step[L].x][now.step[L].y].se-L,0)>=2)
 			now.score -= 10 * ppow2[L-1];
 		
-		if (PlayerID == myID && DeathMap[now.x[L]][now.y[L]].fi && DeathMap[now.x[L]][now.y[L]].fi+1-std::max(DeathShort[now.x[L]][now.y[L]]-1-L,0)>=2)
+		if (PlayerID == myID && DeathMap[now.step[L].x][now.step[L].y].fi && DeathMap[now.step[L].x][now.step[L].y].fi+1-std::max(DeathShort[now.step[L].x][now.step[L].y]-1-L,0)>=2)
 			now.score -= 10 * ppow2[L-1];
 	}
 	
-	while (L--) gameField.PopState();
+	while (L--) gameField.PopStateT<H, W>();
+}
+
+void (*MC)(Way &now, int PlayerID, int Round, Pacman::Direction First);
+
+// 与 GameField::SelectSimulator 对应，选用特化的模拟函数
+inline void SelectMC()
+{
+	MC = MCT<0, 0>;
+#define PACMAN_SELECT_MC(H, W) if (h == H && w == W) MC = MCT<H, W>;
+	PACMAN_BOARD_SIZES(PACMAN_SELECT_MC)
+#undef PACMAN_SELECT_MC
 }
 
 int color[MAX_PLAYER_COUNT][FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
@@ -1440,6 +2436,138 @@ inline int Repeat(int o)
 	return -2;
 }
 
+// Fight 中对手 i 用到的概率，每个对手只算一次；a 是 CanAvoid 的情形（1：自己能躲开对手的金光，2：对手能躲开自己的）
+struct FightPro
+{
+	int a;
+	double shoot, shootFlee, hit, pred, eat, step, aim;
+} FightOpp[MAX_PLAYER_COUNT];
+
+inline FightPro FightProOf(int i)
+{
+	FightPro p;
+	p.a = (CanAvoid(myID,i) ? 1 : 0) + (CanAvoid(i,myID) ? 2 : 0);
+	p.shoot = Poss(Count[i][p.a][0], Count[i][p.a][1]); // 同一直线上时朝自己发射金光
+	p.shootFlee = Poss(Count[i][p.a][4], Count[i][p.a][5]); // 自己预测会留在这条直线上时仍发射
+	p.hit = Poss(Count[i][p.a][2], Count[i][p.a][3]); // 躲不开自己的金光
+	p.pred = Poss(Count[i][6][0], Count[i][6][1]); // 动作和 Pred 一致
+	p.eat = Poss(Count[i][5][0], Count[i][5][1]); // 自己走到豆子上时朝那一格发射
+	p.step = Poss(Count[i][5][2], Count[i][5][3]); // 自己走到其他格子时朝那一格发射
+	p.aim = Poss(Count[i][4][0], Count[i][4][1]); // 走进自己的射线后没有躲开
+	return p;
+}
+
+// 对手 i 的射线方向 FightRay[k] 打到自己时依次结算（与原来逐个方向展开时的顺序一致）
+const int FightRay[4] = {2, 0, 3, 1};
+
+// 竖着走（0、2）到的格子要看对手左右的射线，横着走要看上下的
+const int FightCross[2] = {2|8, 1|4};
+
+// 按动作 -1~7 写入请求：mask 中第 d+1 位为 1 的动作用 other，其余用 slot
+inline void FightReq(int i, int c, int slot, int mask, int other)
+{
+	rep(d, -1, 7) Addreq(i, d, c, (mask >> (d+1) & 1) ? other : slot);
+}
+
+// 对手 i 向 t 发射的金光会打到自己时，是否要考虑对手发射；q 是发射的概率，flee 为自己预测会留在这条直线上
+inline bool FightLineShot(int i, int t, bool &flee, double &q)
+{
+	const FightPro &p = FightOpp[i];
+	if (gameField.players[i].strength <= SkillCost) return false;
+	flee = (p.a & 1) && (Pred[myID] == -1 || Pred[myID] == t || Pred[myID] == (t^2));
+	q = flee ? p.shootFlee : p.shoot;
+	return !flee || q >= 0.3;
+}
+
+// 同上，自己反过来朝对手发射时对手是否可能躲不开（由对手预测的动作决定）
+inline bool FightLineCounter(int i, int t)
+{
+	const Pacman::Player &o = gameField.players[i];
+	Pii op = Pii(o.row, o.col);
+	int u = t & 1;
+	return (FightOpp[i].a & 2) && (Pred[i] == -1 || (Pred[i] == u && (color[myID][GO(op, u).fi][GO(op, u).se] & 15)) || (Pred[i] == (u^2) && (color[myID][GO(op, u^2).fi][GO(op, u^2).se] & 15)));
+}
+
+// 对手 i 向 t 发射的金光会打到自己：结算对手发射时自己各个走法的损失，以及自己反过来朝对手发射的收益
+// 只写 Point，要统计的对手动作由 FightLineReq 记录
+inline void FightLine(int i, int t)
+{
+	const FightPro &p = FightOpp[i];
+	const Pacman::Player &o = gameField.players[i];
+	Pii me = Pii(gameField.players[myID].row, gameField.players[myID].col), op = Pii(o.row, o.col);
+	int s = gameField.players[myID].strength, u = t & 1;
+	bool flee;
+	double q;
+	
+	if (FightLineShot(i, t, flee, q))
+	{
+		// 不动或顺着射线走躲不开；迎着走只有紧挨着对手且不比对手弱时才没事；横着走能躲开
+		Point[0] += q * -SkillCost*2;
+		rep(d, 0, 3)
+			if (d == t) Point[d+1] += q * -SkillCost*2;
+			else if (d == (t^2)) Point[d+1] += q * ((GO(op, t) == me && s >= o.strength) ? 0 : -SkillCost*2);
+		
+		// 沿射线走到的格子两侧都是墙时，下一回合还在射线上
+		rep(d, 0, 3) if ((d & 1) == u)
+		{
+			Pii c = GO(me, d);
+			if ((gameField.fieldStatic[c.fi][c.se] & FightCross[u]) == FightCross[u]) Point[d+1] += q * -SkillCost;
+		}
+	}
+	
+	if (gameField.players[myID].strength > SkillCost)
+	{
+		int k = 5 + (t^2);
+		if (FightLineCounter(i, t))
+		{
+			Point[k] += p.hit * p.pred * +SkillCost*0.5,
+			Point[k] += (1.0 - p.hit * p.pred) * -SkillCost;
+		}
+		if ((p.a & 2) == 0) Point[k] += +SkillCost*0.5;
+		if ((p.a & 1) == 0) Point[k] += +SkillCost*0.6;
+	}
+}
+
+// FightLine 用到的统计请求：对手发射与否、被自己瞄准时的走法
+inline void FightLineReq(int i, int t)
+{
+	bool flee;
+	double q;
+	if (FightLineShot(i, t, flee, q))
+		FightReq(i, FightOpp[i].a, flee ? 5 : 1, 1 << (t+5), flee ? 4 : 0);
+	if (gameField.players[myID].strength > SkillCost && FightLineCounter(i, t))
+		FightReq(i, FightOpp[i].a, 2, (t & 1) ? (1 << 1 | 1 << 3) : (1 << 2 | 1 << 4), 3);
+}
+
+// 自己向 d 走到 c 时对手 i 朝 c 发射的概率，不值得考虑时为 0；eat 为自己是去吃 c 上的豆子
+inline double FightStepPro(int i, int d, Pii c, bool &eat)
+{
+	eat = Pred[myID] == d && (gameField.fieldContent[c.fi][c.se] & (16+32));
+	double q = eat ? FightOpp[i].eat : FightOpp[i].step;
+	return q <= (eat ? 0.35 : 0.2) ? 0 : q;
+}
+
+// 自己向 d 走到 c，对手 i 与 d 垂直的射线经过 c：结算对手朝 c 发射的损失，只写 Point
+inline void FightStep(int i, int d, Pii c)
+{
+	bool eat;
+	double q = FightStepPro(i, d, c, eat);
+	if (q) Point[d+1] += q * -SkillCost*1.5;
+}
+
+// FightStep 用到的统计请求
+inline void FightStepReq(int i, int d, Pii c)
+{
+	bool eat;
+	if (!FightStepPro(i, d, c, eat)) return;
+	
+	// 例外的两个动作是对手朝 c 的两个方向发射；横着走时向下发射看的是 5 而不是 4，与原来一致
+	static const int bit[2][2] = {{2, 8}, {1, 5}};
+	int u = d & 1, mask = 0;
+	rep(j, 0, 1) if (color[i][c.fi][c.se] & bit[u][j]) mask |= 1 << (4 + (u^1) + 2*j + 1);
+	FightReq(i, 5, eat ? 1 : 3, mask, eat ? 0 : 2);
+}
+
 void Fight()
 {
 	int tmpCount[4], tmpPred[4];
@@ -1479,509 +2607,47 @@ void Fight()
 					if (a == tmp) break;
 					FirstRoundMap[a.fi][a.se] += -SkillCost*2;
 				}
-				rep(d, -1, 7) Request[++RequestNum] = Addreq(i, d, PlayWall[i]?0:2, (d>=4 && (color[j][x][y] & (1<<(d-4))))?0:1);
+				rep(d, -1, 7) Addreq(i, d, PlayWall[i]?0:2, (d>=4 && (color[j][x][y] & (1<<(d-4))))?0:1);
 			}
 	
 	rep(i, 0, 3) if (i != myID && !gameField.players[i].dead)
-		rep(j, -1, 3) Request[++RequestNum] = Addreq(i, j, 6, (Pred[i]!=j)?1:0);
+		rep(j, -1, 3) Addreq(i, j, 6, (Pred[i]!=j)?1:0);
 	
-	int x = gameField.players[myID].row, y = gameField.players[myID].col, tmpx = x, tmpy = y, s = gameField.players[myID].strength;
+	int x = gameField.players[myID].row, y = gameField.players[myID].col;
 	
-	rep(i, 0, 3) if (color[i][x][y] && i != myID)
-	{
-		/* if (color[i][x][y] & 16)
-		{
-			if (Pred[i] != -1 && s > SkillCost && s == gameField.players[i].strength && )
-				Point[5+Pred[i]] += Poss(Count[i][6][0], Count[i][6][1]) * +SkillCost,
-				Point[5+Pred[i]] += Poss(Count[i][6][1], Count[i][6][0]) * -SkillCost;
-		} */
-		
-		if (color[i][x][y] & 4)
-		{
-			int a = (CanAvoid(myID,i) ? 1 : 0) + (CanAvoid(i,myID) ? 2 : 0);
-			
-			if (gameField.players[i].strength > SkillCost)
-			{
-				if ((a & 1) && (Pred[myID] == -1 || Pred[myID] == 0 || Pred[myID] == 2))
-				{
-					if (Poss(Count[i][a][4], Count[i][a][5]) < 0.3) goto break1;
-					
-					Point[0] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][4], Count[i][a][5]) * ((inc(gameField.players[i].row,h) == x && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					Point[2] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					Point[3] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					Point[4] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					
-					if ((gameField.fieldStatic[dec(x,h)][y] & 10) == 10) Point[1] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					if ((gameField.fieldStatic[inc(x,h)][y] & 10) == 10) Point[3] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 5);
-					Request[++RequestNum] = Addreq(i, 0, a, 5);
-					Request[++RequestNum] = Addreq(i, 1, a, 5);
-					Request[++RequestNum] = Addreq(i, 2, a, 5);
-					Request[++RequestNum] = Addreq(i, 3, a, 5);
-					Request[++RequestNum] = Addreq(i, 4, a, 5);
-					Request[++RequestNum] = Addreq(i, 5, a, 5);
-					Request[++RequestNum] = Addreq(i, 6, a, 4);
-					Request[++RequestNum] = Addreq(i, 7, a, 5);
-				}
-				else
-				{
-					Point[0] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][0], Count[i][a][1]) * ((inc(gameField.players[i].row,h) == x && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					Point[2] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					Point[3] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					Point[4] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					
-					if ((gameField.fieldStatic[dec(x,h)][y] & 10) == 10) Point[1] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					if ((gameField.fieldStatic[inc(x,h)][y] & 10) == 10) Point[3] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 1);
-					Request[++RequestNum] = Addreq(i, 0, a, 1);
-					Request[++RequestNum] = Addreq(i, 1, a, 1);
-					Request[++RequestNum] = Addreq(i, 2, a, 1);
-					Request[++RequestNum] = Addreq(i, 3, a, 1);
-					Request[++RequestNum] = Addreq(i, 4, a, 1);
-					Request[++RequestNum] = Addreq(i, 5, a, 1);
-					Request[++RequestNum] = Addreq(i, 6, a, 0);
-					Request[++RequestNum] = Addreq(i, 7, a, 1);
-				}
-			}
-			
-			break1: if (s > SkillCost)
-			{
-				if ((a & 2) && (Pred[i] == -1 || (Pred[i] == 0 && (color[myID][dec(gameField.players[i].row,h)][gameField.players[i].col] & 15)) || (Pred[i] == 2 && (color[myID][inc(gameField.players[i].row,h)][gameField.players[i].col] & 15))))
-				{
-					Point[5] += Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1]) * +SkillCost*0.5,
-					Point[5] += (1.0 - Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1])) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 2),
-					Request[++RequestNum] = Addreq(i, 0, a, 2),
-					Request[++RequestNum] = Addreq(i, 1, a, 3),
-					Request[++RequestNum] = Addreq(i, 2, a, 2),
-					Request[++RequestNum] = Addreq(i, 3, a, 3),
-					Request[++RequestNum] = Addreq(i, 4, a, 2),
-					Request[++RequestNum] = Addreq(i, 5, a, 2),
-					Request[++RequestNum] = Addreq(i, 6, a, 2),
-					Request[++RequestNum] = Addreq(i, 7, a, 2);
-				}
-				if ((a & 2) == 0) Point[5] += +SkillCost*0.5;
-				if ((a & 1) == 0) Point[5] += +SkillCost*0.6;
-			}
-		}
-		
-		if (color[i][x][y] & 1)
-		{
-			int a = (CanAvoid(myID,i) ? 1 : 0) + (CanAvoid(i,myID) ? 2 : 0);
-			
-			if (gameField.players[i].strength > SkillCost)
-			{
-				if ((a & 1) && (Pred[myID] == -1 || Pred[myID] == 0 || Pred[myID] == 2))
-				{
-					if (Poss(Count[i][a][4], Count[i][a][5]) < 0.3) goto break2;
-					
-					Point[0] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					Point[2] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					Point[3] += Poss(Count[i][a][4], Count[i][a][5]) * ((dec(gameField.players[i].row,h) == x && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					Point[4] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					
-					if ((gameField.fieldStatic[dec(x,h)][y] & 10) == 10) Point[1] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					if ((gameField.fieldStatic[inc(x,h)][y] & 10) == 10) Point[3] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 5);
-					Request[++RequestNum] = Addreq(i, 0, a, 5);
-					Request[++RequestNum] = Addreq(i, 1, a, 5);
-					Request[++RequestNum] = Addreq(i, 2, a, 5);
-					Request[++RequestNum] = Addreq(i, 3, a, 5);
-					Request[++RequestNum] = Addreq(i, 4, a, 4);
-					Request[++RequestNum] = Addreq(i, 5, a, 5);
-					Request[++RequestNum] = Addreq(i, 6, a, 5);
-					Request[++RequestNum] = Addreq(i, 7, a, 5);
-				}
-				else
-				{
-					Point[0] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					Point[2] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					Point[3] += Poss(Count[i][a][0], Count[i][a][1]) * ((dec(gameField.players[i].row,h) == x && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					Point[4] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					
-					if ((gameField.fieldStatic[dec(x,h)][y] & 10) == 10) Point[1] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					if ((gameField.fieldStatic[inc(x,h)][y] & 10) == 10) Point[3] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 1);
-					Request[++RequestNum] = Addreq(i, 0, a, 1);
-					Request[++RequestNum] = Addreq(i, 1, a, 1);
-					Request[++RequestNum] = Addreq(i, 2, a, 1);
-					Request[++RequestNum] = Addreq(i, 3, a, 1);
-					Request[++RequestNum] = Addreq(i, 4, a, 0);
-					Request[++RequestNum] = Addreq(i, 5, a, 1);
-					Request[++RequestNum] = Addreq(i, 6, a, 1);
-					Request[++RequestNum] = Addreq(i, 7, a, 1);
-				}
-			}
-			
-			break2: if (s > SkillCost)
-			{
-				if ((a & 2) && (Pred[i] == -1 || (Pred[i] == 0 && (color[myID][dec(gameField.players[i].row,h)][gameField.players[i].col] & 15)) || (Pred[i] == 2 && (color[myID][inc(gameField.players[i].row,h)][gameField.players[i].col] & 15))))
-				{
-					Point[7] += Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1]) * +SkillCost*0.5,
-					Point[7] += (1.0 - Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1])) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 2),
-					Request[++RequestNum] = Addreq(i, 0, a, 2),
-					Request[++RequestNum] = Addreq(i, 1, a, 3),
-					Request[++RequestNum] = Addreq(i, 2, a, 2),
-					Request[++RequestNum] = Addreq(i, 3, a, 3),
-					Request[++RequestNum] = Addreq(i, 4, a, 2),
-					Request[++RequestNum] = Addreq(i, 5, a, 2),
-					Request[++RequestNum] = Addreq(i, 6, a, 2),
-					Request[++RequestNum] = Addreq(i, 7, a, 2);
-				}
-				if ((a & 2) == 0) Point[7] += +SkillCost*0.5;
-				if ((a & 1) == 0) Point[7] += +SkillCost*0.6;
-			}
-		}
-		
-		if (color[i][x][y] & 8)
-		{
-			int a = (CanAvoid(myID,i) ? 1 : 0) + (CanAvoid(i,myID) ? 2 : 0);
-			
-			if (gameField.players[i].strength > SkillCost)
-			{
-				if ((a & 1) && (Pred[myID] == -1 || Pred[myID] == 1 || Pred[myID] == 3))
-				{
-					if (Poss(Count[i][a][4], Count[i][a][5]) < 0.3) goto break3;
-					
-					Point[0] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					Point[2] += Poss(Count[i][a][4], Count[i][a][5]) * ((dec(gameField.players[i].col,w) == y && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					Point[3] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					Point[4] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					
-					if ((gameField.fieldStatic[x][inc(y,w)] & 5) == 5) Point[2] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					if ((gameField.fieldStatic[x][dec(y,w)] & 5) == 5) Point[4] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 5);
-					Request[++RequestNum] = Addreq(i, 0, a, 5);
-					Request[++RequestNum] = Addreq(i, 1, a, 5);
-					Request[++RequestNum] = Addreq(i, 2, a, 5);
-					Request[++RequestNum] = Addreq(i, 3, a, 5);
-					Request[++RequestNum] = Addreq(i, 4, a, 5);
-					Request[++RequestNum] = Addreq(i, 5, a, 5);
-					Request[++RequestNum] = Addreq(i, 6, a, 5);
-					Request[++RequestNum] = Addreq(i, 7, a, 4);
-				}
-				else
-				{
-					Point[0] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					Point[2] += Poss(Count[i][a][0], Count[i][a][1]) * ((dec(gameField.players[i].col,w) == y && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					Point[3] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					Point[4] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					
-					if ((gameField.fieldStatic[x][inc(y,w)] & 5) == 5) Point[2] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					if ((gameField.fieldStatic[x][dec(y,w)] & 5) == 5) Point[4] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 1);
-					Request[++RequestNum] = Addreq(i, 0, a, 1);
-					Request[++RequestNum] = Addreq(i, 1, a, 1);
-					Request[++RequestNum] = Addreq(i, 2, a, 1);
-					Request[++RequestNum] = Addreq(i, 3, a, 1);
-					Request[++RequestNum] = Addreq(i, 4, a, 1);
-					Request[++RequestNum] = Addreq(i, 5, a, 1);
-					Request[++RequestNum] = Addreq(i, 6, a, 1);
-					Request[++RequestNum] = Addreq(i, 7, a, 0);
-				}
-			}
-			
-			break3: if (s > SkillCost)
-			{
-				if ((a & 2) && (Pred[i] == -1 || (Pred[i] == 1 && (color[myID][gameField.players[i].row][inc(gameField.players[i].col,w)] & 15)) || (Pred[i] == 3 && (color[myID][gameField.players[i].row][dec(gameField.players[i].col,w)] & 15))))
-				{
-					Point[6] += Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1]) * +SkillCost*0.5,
-					Point[6] += (1.0 - Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1])) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 2),
-					Request[++RequestNum] = Addreq(i, 0, a, 3),
-					Request[++RequestNum] = Addreq(i, 1, a, 2),
-					Request[++RequestNum] = Addreq(i, 2, a, 3),
-					Request[++RequestNum] = Addreq(i, 3, a, 2),
-					Request[++RequestNum] = Addreq(i, 4, a, 2),
-					Request[++RequestNum] = Addreq(i, 5, a, 2),
-					Request[++RequestNum] = Addreq(i, 6, a, 2),
-					Request[++RequestNum] = Addreq(i, 7, a, 2);
-				}
-				if ((a & 2) == 0) Point[6] += +SkillCost*0.5;
-				if ((a & 1) == 0) Point[6] += +SkillCost*0.6;
-			}
-		}
-		
-		if (color[i][x][y] & 2)
-		{
-			int a = (CanAvoid(myID,i) ? 1 : 0) + (CanAvoid(i,myID) ? 2 : 0);
-			
-			if (gameField.players[i].strength > SkillCost)
-			{
-				if ((a & 1) && (Pred[myID] == -1 || Pred[myID] == 1 || Pred[myID] == 3))
-				{
-					if (Poss(Count[i][a][4], Count[i][a][5]) < 0.3) goto break4;
-					
-					Point[0] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					Point[2] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost*2;
-					Point[3] += Poss(Count[i][a][4], Count[i][a][5]) * 0;
-					Point[4] += Poss(Count[i][a][4], Count[i][a][5]) * ((inc(gameField.players[i].col,w) == y && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					
-					if ((gameField.fieldStatic[x][inc(y,w)] & 5) == 5) Point[2] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					if ((gameField.fieldStatic[x][dec(y,w)] & 5) == 5) Point[4] += Poss(Count[i][a][4], Count[i][a][5]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 5);
-					Request[++RequestNum] = Addreq(i, 0, a, 5);
-					Request[++RequestNum] = Addreq(i, 1, a, 5);
-					Request[++RequestNum] = Addreq(i, 2, a, 5);
-					Request[++RequestNum] = Addreq(i, 3, a, 5);
-					Request[++RequestNum] = Addreq(i, 4, a, 5);
-					Request[++RequestNum] = Addreq(i, 5, a, 4);
-					Request[++RequestNum] = Addreq(i, 6, a, 5);
-					Request[++RequestNum] = Addreq(i, 7, a, 5);
-				}
-				else
-				{
-					Point[0] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					Point[1] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					Point[2] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost*2;
-					Point[3] += Poss(Count[i][a][0], Count[i][a][1]) * 0;
-					Point[4] += Poss(Count[i][a][0], Count[i][a][1]) * ((inc(gameField.players[i].col,w) == y && s >= gameField.players[i].strength) ? 0 : -SkillCost*2);
-					
-					if ((gameField.fieldStatic[x][inc(y,w)] & 5) == 5) Point[2] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					if ((gameField.fieldStatic[x][dec(y,w)] & 5) == 5) Point[4] += Poss(Count[i][a][0], Count[i][a][1]) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 1);
-					Request[++RequestNum] = Addreq(i, 0, a, 1);
-					Request[++RequestNum] = Addreq(i, 1, a, 1);
-					Request[++RequestNum] = Addreq(i, 2, a, 1);
-					Request[++RequestNum] = Addreq(i, 3, a, 1);
-					Request[++RequestNum] = Addreq(i, 4, a, 1);
-					Request[++RequestNum] = Addreq(i, 5, a, 0);
-					Request[++RequestNum] = Addreq(i, 6, a, 1);
-					Request[++RequestNum] = Addreq(i, 7, a, 1);
-				}
-			}
-			
-			break4: if (s > SkillCost)
-			{
-				if ((a & 2) && (Pred[i] == -1 || (Pred[i] == 1 && (color[myID][gameField.players[i].row][inc(gameField.players[i].col,w)] & 15)) || (Pred[i] == 3 && (color[myID][gameField.players[i].row][dec(gameField.players[i].col,w)] & 15))))
-				{
-					Point[8] += Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1]) * +SkillCost*0.5,
-					Point[8] += (1.0 - Poss(Count[i][a][2], Count[i][a][3]) * Poss(Count[i][6][0], Count[i][6][1])) * -SkillCost;
-					
-					Request[++RequestNum] = Addreq(i, -1, a, 2),
-					Request[++RequestNum] = Addreq(i, 0, a, 3),
-					Request[++RequestNum] = Addreq(i, 1, a, 2),
-					Request[++RequestNum] = Addreq(i, 2, a, 3),
-					Request[++RequestNum] = Addreq(i, 3, a, 2),
-					Request[++RequestNum] = Addreq(i, 4, a, 2),
-					Request[++RequestNum] = Addreq(i, 5, a, 2),
-					Request[++RequestNum] = Addreq(i, 6, a, 2),
-					Request[++RequestNum] = Addreq(i, 7, a, 2);
-				}
-				if ((a & 2) == 0) Point[8] += +SkillCost*0.5;
-				if ((a & 1) == 0) Point[8] += +SkillCost*0.6;
-			}
-		}
-	}
+	rep(i, 0, 3) if (i != myID && !gameField.players[i].dead) FightOpp[i] = FightProOf(i);
 	
-	if ((gameField.fieldStatic[x][y] & 1) == 0)
-	{
-		x = dec(x,h);
-		rep(i, 0, 3) if (i != myID && (color[i][x][y] & 10) && gameField.players[i].strength > SkillCost)
-		{
-			if (Pred[myID] == 0 && (gameField.fieldContent[x][y] & (16+32)))
-			{
-				if (Poss(Count[i][5][0], Count[i][5][1]) <= 0.35) continue;
-				
-				Point[1] += Poss(Count[i][5][0], Count[i][5][1]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 0, 5, 1);
-				Request[++RequestNum] = Addreq(i, 1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 2, 5, 1);
-				Request[++RequestNum] = Addreq(i, 3, 5, 1);
-				Request[++RequestNum] = Addreq(i, 4, 5, 1);
-				Request[++RequestNum] = Addreq(i, 5, 5, (color[i][x][y]&2)?0:1);
-				Request[++RequestNum] = Addreq(i, 6, 5, 1);
-				Request[++RequestNum] = Addreq(i, 7, 5, (color[i][x][y]&8)?0:1);
-			}
-			else
-			{
-				if (Poss(Count[i][5][2], Count[i][5][3]) <= 0.2) continue;
-				
-				Point[1] += Poss(Count[i][5][2], Count[i][5][3]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 0, 5, 3);
-				Request[++RequestNum] = Addreq(i, 1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 2, 5, 3);
-				Request[++RequestNum] = Addreq(i, 3, 5, 3);
-				Request[++RequestNum] = Addreq(i, 4, 5, 3);
-				Request[++RequestNum] = Addreq(i, 5, 5, (color[i][x][y]&2)?2:3);
-				Request[++RequestNum] = Addreq(i, 6, 5, 3);
-				Request[++RequestNum] = Addreq(i, 7, 5, (color[i][x][y]&8)?2:3);
-			}
-		}
-		x = tmpx;
-	}
+	// 各方向的射线按原来的顺序（下、上、左、右）结算，Point 的累加顺序不变
+	rep(i, 0, 3) if (color[i][x][y] && i != myID)
+		rep(k, 0, 3) if (color[i][x][y] & (1 << FightRay[k])) FightLine(i, FightRay[k]);
 	
-	if ((gameField.fieldStatic[x][y] & 2) == 0)
+	rep(d, 0, 3) if ((gameField.fieldStatic[x][y] & (1 << d)) == 0)
 	{
-		y = inc(y,w);
-		rep(i, 0, 3) if (i != myID && (color[i][x][y] & 5) && gameField.players[i].strength > SkillCost)
-		{
-			if (Pred[myID] == 1 && (gameField.fieldContent[x][y] & (16+32)))
-			{
-				if (Poss(Count[i][5][0], Count[i][5][1]) <= 0.35) continue;
-				
-				Point[2] += Poss(Count[i][5][0], Count[i][5][1]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 0, 5, 1);
-				Request[++RequestNum] = Addreq(i, 1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 2, 5, 1);
-				Request[++RequestNum] = Addreq(i, 3, 5, 1);
-				Request[++RequestNum] = Addreq(i, 4, 5, (color[i][x][y]&1)?0:1);
-				Request[++RequestNum] = Addreq(i, 5, 5, 1);
-				Request[++RequestNum] = Addreq(i, 6, 5, (color[i][x][y]&5)?0:1);
-				Request[++RequestNum] = Addreq(i, 7, 5, 1);
-			}
-			else
-			{
-				if (Poss(Count[i][5][2], Count[i][5][3]) <= 0.2) continue;
-				
-				Point[2] += Poss(Count[i][5][2], Count[i][5][3]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 0, 5, 3);
-				Request[++RequestNum] = Addreq(i, 1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 2, 5, 3);
-				Request[++RequestNum] = Addreq(i, 3, 5, 3);
-				Request[++RequestNum] = Addreq(i, 4, 5, (color[i][x][y]&1)?2:3);
-				Request[++RequestNum] = Addreq(i, 5, 5, 3);
-				Request[++RequestNum] = Addreq(i, 6, 5, (color[i][x][y]&5)?2:3);
-				Request[++RequestNum] = Addreq(i, 7, 5, 3);
-			}
-		}
-		y = tmpy;
+		Pii c = GO(Pii(x,y), d);
+		rep(i, 0, 3) if (i != myID && (color[i][c.fi][c.se] & FightCross[d & 1]) && gameField.players[i].strength > SkillCost) FightStep(i, d, c);
 	}
 	
-	if ((gameField.fieldStatic[x][y] & 4) == 0)
+	// 上面两种情形要统计的对手动作单独记录，FightLine/FightStep 本身只写 Point
+	rep(i, 0, 3) if (color[i][x][y] && i != myID)
+		rep(k, 0, 3) if (color[i][x][y] & (1 << FightRay[k])) FightLineReq(i, FightRay[k]);
+	rep(d, 0, 3) if ((gameField.fieldStatic[x][y] & (1 << d)) == 0)
 	{
-		x = inc(x,h);
-		rep(i, 0, 3) if (i != myID && (color[i][x][y] & 10) && gameField.players[i].strength > SkillCost)
-		{
-			if (Pred[myID] == 2 && (gameField.fieldContent[x][y] & (16+32)))
-			{
-				if (Poss(Count[i][5][0], Count[i][5][1]) <= 0.35) continue;
-				
-				Point[3] += Poss(Count[i][5][0], Count[i][5][1]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 0, 5, 1);
-				Request[++RequestNum] = Addreq(i, 1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 2, 5, 1);
-				Request[++RequestNum] = Addreq(i, 3, 5, 1);
-				Request[++RequestNum] = Addreq(i, 4, 5, 1);
-				Request[++RequestNum] = Addreq(i, 5, 5, (color[i][x][y]&2)?0:1);
-				Request[++RequestNum] = Addreq(i, 6, 5, 1);
-				Request[++RequestNum] = Addreq(i, 7, 5, (color[i][x][y]&8)?0:1);
-			}
-			else
-			{
-				if (Poss(Count[i][5][2], Count[i][5][3]) <= 0.2) continue;
-				
-				Point[3] += Poss(Count[i][5][2], Count[i][5][3]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 0, 5, 3);
-				Request[++RequestNum] = Addreq(i, 1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 2, 5, 3);
-				Request[++RequestNum] = Addreq(i, 3, 5, 3);
-				Request[++RequestNum] = Addreq(i, 4, 5, 3);
-				Request[++RequestNum] = Addreq(i, 5, 5, (color[i][x][y]&2)?2:3);
-				Request[++RequestNum] = Addreq(i, 6, 5, 3);
-				Request[++RequestNum] = Addreq(i, 7, 5, (color[i][x][y]&8)?2:3);
-			}
-		}
-		x = tmpx;
-	}
-	
-	if ((gameField.fieldStatic[x][y] & 8) == 0)
-	{
-		y = dec(y,w);
-		rep(i, 0, 3) if (i != myID && (color[i][x][y] & 5) && gameField.players[i].strength > SkillCost)
-		{
-			if (Pred[myID] == 3 && (gameField.fieldContent[x][y] & (16+32)))
-			{
-				if (Poss(Count[i][5][0], Count[i][5][1]) <= 0.35) continue;
-				
-				Point[4] += Poss(Count[i][5][0], Count[i][5][1]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 0, 5, 1);
-				Request[++RequestNum] = Addreq(i, 1, 5, 1);
-				Request[++RequestNum] = Addreq(i, 2, 5, 1);
-				Request[++RequestNum] = Addreq(i, 3, 5, 1);
-				Request[++RequestNum] = Addreq(i, 4, 5, (color[i][x][y]&1)?0:1);
-				Request[++RequestNum] = Addreq(i, 5, 5, 1);
-				Request[++RequestNum] = Addreq(i, 6, 5, (color[i][x][y]&5)?0:1);
-				Request[++RequestNum] = Addreq(i, 7, 5, 1);
-			}
-			else
-			{
-				if (Poss(Count[i][5][2], Count[i][5][3]) <= 0.2) continue;
-				
-				Point[4] += Poss(Count[i][5][2], Count[i][5][3]) * -SkillCost*1.5;
-				
-				Request[++RequestNum] = Addreq(i, -1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 0, 5, 3);
-				Request[++RequestNum] = Addreq(i, 1, 5, 3);
-				Request[++RequestNum] = Addreq(i, 2, 5, 3);
-				Request[++RequestNum] = Addreq(i, 3, 5, 3);
-				Request[++RequestNum] = Addreq(i, 4, 5, (color[i][x][y]&1)?2:3);
-				Request[++RequestNum] = Addreq(i, 5, 5, 3);
-				Request[++RequestNum] = Addreq(i, 6, 5, (color[i][x][y]&5)?2:3);
-				Request[++RequestNum] = Addreq(i, 7, 5, 3);
-			}
-		}
-		y = tmpy;
+		Pii c = GO(Pii(x,y), d);
+		rep(i, 0, 3) if (i != myID && (color[i][c.fi][c.se] & FightCross[d & 1]) && gameField.players[i].strength > SkillCost) FightStepReq(i, d, c);
 	}
 	
 	rep(i, 0, 3) if (i != myID && !gameField.players[i].dead && !color[myID][gameField.players[i].row][gameField.players[i].col] && Pred[i]!=-1)
 	{
-		int xx = gameField.players[i].row, yy = gameField.players[i].col, d = Pred[i];
+		Pii c = GO(Pii(gameField.players[i].row,gameField.players[i].col), Pred[i]);
 		
-		if (d == 0) xx = (xx-1+h) % h;
-		if (d == 1) yy = (yy+1+w) % w;
-		if (d == 2) xx = (xx+1+h) % h;
-		if (d == 3) yy = (yy-1+w) % w;
-			
-		if (color[myID][xx][yy] & 15)
-		{
-			if (color[myID][xx][yy] & 1) 
-				Point[5] += Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1]) * +SkillCost*0.6,
-				Point[5] += (1 - Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1])) * -SkillCost;
-			if (color[myID][xx][yy] & 2) 
-				Point[6] += Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1]) * +SkillCost*0.6,
-				Point[6] += (1 - Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1])) * -SkillCost;
-			if (color[myID][xx][yy] & 4) 
-				Point[7] += Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1]) * +SkillCost*0.6,
-				Point[7] += (1 - Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1])) * -SkillCost;
-			if (color[myID][xx][yy] & 8) 
-				Point[8] += Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1]) * +SkillCost*0.6,
-				Point[8] += (1 - Poss(Count[i][6][0], Count[i][6][1]) * Poss(Count[i][4][0], Count[i][4][1])) * -SkillCost;
+		if (color[myID][c.fi][c.se] & 15)
+		{
+			const FightPro &p = FightOpp[i];
+			rep(k, 0, 3) if (color[myID][c.fi][c.se] & (1 << k))
+				Point[5+k] += p.pred * p.aim * +SkillCost*0.6,
+				Point[5+k] += (1 - p.pred * p.aim) * -SkillCost;
 			
-			rep(a, 0, 4) Request[++RequestNum] = Addreq(i, a-1, 4, (a-1==d)?0:1);
+			rep(a, 0, 4) Addreq(i, a-1, 4, (a-1==Pred[i])?0:1);
 		}
 	}
 	
@@ -1994,8 +2660,6 @@ void Fight()
 	rep(a, 5, 8) if (FightMX == -1 || Point[a] > Point[FightMX]) FightMX = a;
 }
 
-bool way_cmp(Way a, Way b){return a.score > b.score;}
-
 void Init(int o)
 {
 	rep(i, 0, gameField.height-1) rep(j, 0, gameField.width-1) rep(a, 0, MAX_PLAYER_COUNT-1) rep(b, 0, 100) 
@@ -2025,13 +2689,104 @@ inline Pacman::Direction Final(Pro a)
 
 bool tmpdead[MAX_PLAYER_COUNT]; int tmpCount;
 
-int ddd[10009];
+int ddd[10009], TopCount;
 
-bool cmp_ddd(int a, int b){return Ways[a].score > Ways[b].score;}
+// 参与选择的路线：分数、在 Ways 中的下标和第一步放在一起，选择时只在这个紧凑的数组上比较，不访问 Ways
+struct WayKey
+{
+	double score; int id, first;
+} Keys[10009];
+
+// 分数相同时先模拟的在前，选择结果与 nth_element 的实现无关
+bool cmp_key(const WayKey &a, const WayKey &b){return a.score > b.score || (a.score == b.score && a.id < b.id);}
 
-#define opp_A 5
 #define opp_B 20
-#define opp_C std::min(WayCount,100)
+#define opp_K 100 // 只保留分数最高的这么多条路线
+#define opp_C TopCount
+
+// 最后一次搜索的步数：所有对手到自己的距离都超过 opp_E 时看 opp_E 步（opp_A 步之后没有对手的信息，只按豆子规划路线），
+// 否则和各轮一样看 opp_A 步。只剩一个对手但离得近时也加深，实测反而略差
+inline int SearchDepth()
+{
+	int x = gameField.players[myID].row, y = gameField.players[myID].col;
+	rep(i, 0, 3) if (i != myID && !gameField.players[i].dead && Dis[x][y][gameField.players[i].row][gameField.players[i].col] <= opp_E) return opp_A;
+	return opp_E;
+}
+
+// 把 Keys[0..n-1] 中分数最高的 opp_K 个（不排序）移到最前面，返回保留的个数；之后的前 opp_K 只可能来自这些和新加入的
+inline int TopSelect(int n)
+{
+	if (n <= opp_K) return n;
+	std::nth_element(Keys, Keys+opp_K, Keys+n, cmp_key);
+	return opp_K;
+}
+
+// 只保留 PlayerID 一人，对每个合法的第一步共模拟 Total 次（每次 Round 步），第一步为 d 的路线分数加上 bonus[d+1]
+// 先每个第一步各模拟 opp_B 次，之后每段次数加倍（逐次分段减半）：每段结束时，没有一条路线进入前 opp_K 的第一步
+// 按最好的分数从低到高淘汰，每次最多淘汰一半，省下的次数留给剩下的第一步；Total 不超过 opp_B 时就是原来的均匀模拟
+// 结束时 ddd[1..opp_C] 按分数从高到低排好
+// 最后一次搜索也不让对手留在场上：试过让对手按 PlayerPro 和 FightOpp 一起模拟，胜率反而低得多，对手的威胁交给 eat/Appear 和 Point 估计
+void Search(int PlayerID, int Round, int Total, const double *bonus)
+{
+	tmpCount = gameField.aliveCount, gameField.aliveCount = 2;
+	rep(i, 0, MAX_PLAYER_COUNT-1) if (i!=PlayerID)
+	{
+		tmpdead[i] = gameField.players[i].dead;
+		if (!gameField.players[i].dead)
+			gameField.players[i].dead = true, 
+			gameField.fieldContent[gameField.players[i].row][gameField.players[i].col] ^= Pacman::playerID2Mask[i]; 
+	}
+	
+	WayCount = 0;
+	int alive[5], aliveCount = 0, keyCount = 0;
+	double best[5];
+	for (Pacman::Direction d = Pacman::stay; d < 4; ++d) if (gameField.ActionValid(PlayerID, d)) alive[aliveCount++] = d, best[d+1] = -1e90;
+	
+	int budget = Total * aliveCount;
+	for (int batch = opp_B; WayCount < budget; batch *= 2)
+	{
+		int n = std::min(batch, (budget - WayCount + aliveCount - 1) / aliveCount);
+		rep(i, 1, n) rep(k, 0, aliveCount-1) if (WayCount < budget)
+		{
+			// 只需初始化分数和出发点，后面的步由 MC 逐步写入
+			Way &now = Ways[++WayCount];
+			now.score = now.pos = 0;
+			now.step[0].x = gameField.players[PlayerID].row;
+			now.step[0].y = gameField.players[PlayerID].col;
+			now.step[0].act = 0;
+			now.step[0].strength = gameField.players[PlayerID].strength;
+			MC(now, PlayerID, Round, v(alive[k]));
+			now.score += bonus[alive[k]+1];
+			best[alive[k]+1] = std::max(best[alive[k]+1], now.score);
+			WayKey &key = Keys[keyCount++];
+			key.score = now.score, key.id = WayCount, key.first = alive[k];
+		}
+		
+		if (WayCount >= budget || aliveCount == 1) continue;
+		int inTop[5] = {};
+		keyCount = TopSelect(keyCount);
+		rep(i, 0, keyCount-1) inTop[Keys[i].first+1]++;
+		int drop = aliveCount / 2;
+		while (drop--)
+		{
+			int worst = -1;
+			rep(k, 0, aliveCount-1) if (!inTop[alive[k]+1] && (worst == -1 || best[alive[k]+1] < best[alive[worst]+1])) worst = k;
+			if (worst == -1) break;
+			alive[worst] = alive[--aliveCount];
+		}
+	}
+	TopCount = TopSelect(keyCount);
+	std::sort(Keys, Keys+TopCount, cmp_key);
+	rep(i, 1, TopCount) ddd[i] = Keys[i-1].id;
+	
+	gameField.aliveCount = tmpCount;
+	rep(i, 0, MAX_PLAYER_COUNT-1) if (i!=PlayerID)
+	{
+		if (!tmpdead[i])
+			gameField.fieldContent[gameField.players[i].row][gameField.players[i].col] ^= Pacman::playerID2Mask[i]; 
+		gameField.players[i].dead = tmpdead[i];
+	}
+}
 
 
 
@@ -2158,38 +2913,47 @@ inline string DaCall(int o)
 
 
 
-int main()
+// 清空上一次决策留下的全局状态，使 Decide 可以在同一进程中反复调用
+void ResetBot()
 {
 	ppow[0] = 1; rep(i, 1, 50) ppow[i] = ppow[i-1] * 0.95;
 	ppow2[0] = 1; rep(i, 1, 50) ppow2[i] = ppow2[i-1] * 0.88;
 	ppow3[0] = 1; rep(i, 1, 50) ppow3[i] = ppow3[i-1] * 0.5;
-
-	myID = gameField.ReadInput("input.txt", data, globalData); // 输入，并获得自己ID
 	
-	rep(i, 1, 50) Rand();
+	danger = false; page = 0; WayCount = 0; FightMX = 0; Bean1 = Bean2 = 0;
+	clr(Count, 0); clr(ReqSlot, 0); clr(Control, 0); clr(DeathMap, 0); clr(Apple, 0); clr(Deep, 0);
+	clr(Wall, 0); clr(DeathShort, 0); clr(FirstRoundMap, 0); clr(PlayerPro, 0); std::fill(BeanNow, BeanNow+409, Pii(0,0)); std::fill(BeanWill, BeanWill+409, Pii(0,0)); clr(BeanHere, 0);
+	clr(color, 0); clr(Point, 0); clr(Pred, 0); clr(PlayWall0, 0); clr(PlayWall, 0); clr(tmpdead, 0);
+	Init(0); Init(1); // 此时 gameField 还是上一次的局面，清掉的正是上次用到的区域
 	
+	Log.len = 0; Log.full = false;
+	Profile = TurnProfile();
+}
+
+// 一回合的决策，从 DealWithInputData 到 Final：局面取自 gameField，自己是 myID，
+// 读入 data/globalData 并换成本回合要保存的内容，调试信息写进 Log
+Pacman::Direction Decide()
+{
 	h = gameField.height, w = gameField.width, SkillCost = gameField.SKILL_COST, Interval = gameField.GENERATOR_INTERVAL, BeginturnID = gameField.turnID;
+	SelectMC();
+	RollInit();
 	
 	if (gameField.turnID == 0)
-	{
-		globalData = "";
-		data = "";
-		rep(i, 1, 3)
-		{
-			data += "1 0 0 1 1 0 1 0 0 1 0 1 0 0 1 1 1 1 1 1 1 1 0 0 ";
-			data += '\n';
-		}
-		data += "0";
-		data += '\n';
-	}
+		data = ""; // DealWithInputData 会载入先验
 	
+	LoadGlobalData();
 	DealWithInputData();
 	
 	BeanScoreInit();
+	ProfileLap(PF_DATA);
 	CountDis();
+	ProfileLap(PF_DIS);
 	DeathPlace();
+	ProfileLap(PF_DEATH);
 	WallMap();
+	ProfileLap(PF_WALL);
 	Candy();
+	ProfileLap(PF_CANDY);
 	
 	rep(i, 0, 3) if (i != myID && gameField.players[i].strength > gameField.players[myID].strength)
 	{
@@ -2201,42 +2965,16 @@ int main()
 	int opp_D = 1;
 	rep(Round, 1, opp_A)
 	{
+		BeanRound++;
 		if (Round != 1) Init(page ^= 1); else 
 			rep(i, 0, 3) if (!gameField.players[i].dead)
 				Appear[page^1][gameField.players[i].row][gameField.players[i].col][i][0] = Pdd(gameField.players[i].strength,1);
 		
 		rep(PlayerID, 0, 3) if (!gameField.players[PlayerID].dead)
 		{
-			tmpCount = gameField.aliveCount, gameField.aliveCount = 2;
-			rep(i, 0, MAX_PLAYER_COUNT-1) if (i!=PlayerID)
-			{
-				tmpdead[i] = gameField.players[i].dead;
-				if (!gameField.players[i].dead)
-					gameField.players[i].dead = true, 
-					gameField.fieldContent[gameField.players[i].row][gameField.players[i].col] ^= Pacman::playerID2Mask[i]; 
-			}
-			
-			WayCount = 0; PlayerPro[PlayerID] = emptyPro;
-			
-			rep(i, 1, std::max(opp_B,opp_D)) for (Pacman::Direction d = Pacman::stay; d < 4; ++d) if (gameField.ActionValid(PlayerID, d))
-			{
-				Way &now = Ways[++WayCount]; now = emptyWay;
-				now.strength[0] = gameField.players[PlayerID].strength;
-				now.x[0] = gameField.players[PlayerID].row;
-				now.y[0] = gameField.players[PlayerID].col;
-				MC(now, PlayerID, Round);
-			}
-			
-			gameField.aliveCount = tmpCount;
-			rep(i, 0, MAX_PLAYER_COUNT-1) if (i!=PlayerID)
-			{
-				if (!tmpdead[i])
-					gameField.fieldContent[gameField.players[i].row][gameField.players[i].col] ^= Pacman::playerID2Mask[i]; 
-				gameField.players[i].dead = tmpdead[i];
-			}
-			
-			rep(i, 1, WayCount) ddd[i] = i;
-			std::sort(ddd+1, ddd+1+WayCount, cmp_ddd);
+			PlayerPro[PlayerID] = emptyPro;
+			static const double noBonus[5] = {};
+			Search(PlayerID, Round, std::max(opp_B,opp_D), noBonus);
 			double Small = Ways[ddd[opp_C]].score, Big = Ways[ddd[1]].score;
 			double d = 1, All = 0;
 			rep(i, 1, opp_C) Ways[ddd[i]].pos = Between(Small, Big, Ways[ddd[i]].score) * d, All += Ways[ddd[i]].pos, d *= 0.95;
@@ -2249,7 +2987,7 @@ int main()
 		/* 	if (PlayerID == myID && Round == 5) rep(i, 1, opp_C)
 			{
 				printf("Way %d(%d): %.6lf ", i, ddd[i], Ways[ddd[i]].score);
-				rep(j, 1, Ways[ddd[i]].length) printf("%d ", Ways[ddd[i]].act[j]);
+				rep(j, 1, Ways[ddd[i]].length) printf("%d ", Ways[ddd[i]].step[j].act);
 				puts("");
 			} */
 #endif 
@@ -2259,23 +2997,23 @@ int main()
 			rep(i, 1, opp_C)
 			{
 				Way &g = Ways[ddd[i]]; 
-				PlayerPro[PlayerID].d[g.act[1]+1] += g.pos;
+				PlayerPro[PlayerID].d[g.step[1].act+1] += g.pos;
 				
 				if (g.pos > 0) rep(tmp, 0, g.length)
-					Appear[page][g.x[tmp]][g.y[tmp]][PlayerID][tmp].fi = (Appear[page][g.x[tmp]][g.y[tmp]][PlayerID][tmp].fi * Appear[page][g.x[tmp]][g.y[tmp]][PlayerID][tmp].se + (tmp ? g.strength[tmp-1] : g.strength[tmp]) * g.pos) / (Appear[page][g.x[tmp]][g.y[tmp]][PlayerID][tmp].se + g.pos),
-					Appear[page][g.x[tmp]][g.y[tmp]][PlayerID][tmp].se += g.pos;
+					Appear[page][g.step[tmp].x][g.step[tmp].y][PlayerID][tmp].fi = (Appear[page][g.step[tmp].x][g.step[tmp].y][PlayerID][tmp].fi * Appear[page][g.step[tmp].x][g.step[tmp].y][PlayerID][tmp].se + (tmp ? g.step[tmp-1].strength : g.step[tmp].strength) * g.pos) / (Appear[page][g.step[tmp].x][g.step[tmp].y][PlayerID][tmp].se + g.pos),
+					Appear[page][g.step[tmp].x][g.step[tmp].y][PlayerID][tmp].se += g.pos;
 				
 				rep(tmp, 1, g.length)
 				{
-					int a = g.strength[tmp] - g.strength[tmp-1];
+					int a = g.step[tmp].strength - g.step[tmp-1].strength;
 					while (a < 0) a += gameField.LARGE_FRUIT_ENHANCEMENT;
 					
 					if (a > 0)
 					{
-						eat[page][g.x[tmp]][g.y[tmp]][PlayerID][tmp] += g.pos;
+						eat[page][g.step[tmp].x][g.step[tmp].y][PlayerID][tmp] += g.pos;
 						rep(j, tmp+1, tmp+Interval)
 							if ((tmp+gameField.turnID)/Interval == (j+gameField.turnID)/Interval)
-								eat[page][g.x[tmp]][g.y[tmp]][PlayerID][j] += g.pos;
+								eat[page][g.step[tmp].x][g.step[tmp].y][PlayerID][j] += g.pos;
 					}
 				}
 			}
@@ -2287,76 +3025,91 @@ int main()
 			//rep(i, 0, 4) now.d[i] += PlayerPro[myID].d[i];
 		}
 		
-#ifndef _BOTZONE_ONLINE
+#if !defined(_BOTZONE_ONLINE) && !defined(_PACMAN_LIBRARY)
 		rep(i, 0, 4) printf("%.5lf%c", PlayerPro[myID].d[i], i==4?'\n':' ');
 #endif
+		ProfileLap(PF_ROUND + std::min(Round-1, PF_FIGHT-PF_ROUND-1));
 	}
 	
 	Fight(); //page^=1; 
+	ProfileLap(PF_FIGHT);
 	
-	tmpCount = gameField.aliveCount, gameField.aliveCount = 2;
-	rep(i, 0, MAX_PLAYER_COUNT-1) if (i!=myID)
-	{
-		tmpdead[i] = gameField.players[i].dead;
-		if (!gameField.players[i].dead)
-			gameField.players[i].dead = true, 
-			gameField.fieldContent[gameField.players[i].row][gameField.players[i].col] ^= Pacman::playerID2Mask[i]; 
-	}
-	
-	WayCount = 0; PlayerPro[myID] = emptyPro;
-	
-	rep(i, 1, std::max(opp_B,opp_D)) for (Pacman::Direction d = Pacman::stay; d < 4; ++d) if (gameField.ActionValid(myID, d))
-	{
-		Way &now = Ways[++WayCount]; now = emptyWay;
-		now.strength[0] = gameField.players[myID].strength;
-		now.x[0] = gameField.players[myID].row;
-		now.y[0] = gameField.players[myID].col;
-		MC(now, myID, opp_A);
-	}
-	
-	gameField.aliveCount = tmpCount;
-	rep(i, 0, MAX_PLAYER_COUNT-1) if (i!=myID)
-	{
-		if (!tmpdead[i])
-			gameField.fieldContent[gameField.players[i].row][gameField.players[i].col] ^= Pacman::playerID2Mask[i]; 
-		gameField.players[i].dead = tmpdead[i];
-	}
-	
-	rep(i, 1, WayCount) if (Ways[i].act[1] != -1) 
-		Ways[i].score += Point[Ways[i].act[1]+1]; 
-	else
-	{
-		Ways[i].score += Point[0];
-		//if (Point[FightMX] > SkillCost*0.3 && gameField.players[myID].strength > SkillCost && !danger) Ways[i].score += Point[FightMX];
-	}
-	
-	rep(i, 1, WayCount) ddd[i] = i;
-	std::sort(ddd+1, ddd+1+WayCount, cmp_ddd);
+	// 第一步为 d 的路线加上 Point[d+1]（stay 即 Point[0]）
+	PlayerPro[myID] = emptyPro;
+	int Depth = SearchDepth();
+	Search(myID, Depth, std::max(opp_B,opp_D), Point);
 	double Small = Ways[ddd[opp_C]].score, Big = Ways[ddd[1]].score;
 	double d = 1, All = 0;
 	rep(i, 1, opp_C) Ways[ddd[i]].pos = Between(Small, Big, Ways[ddd[i]].score) * d, All += Ways[ddd[i]].pos, d *= 0.95;
 	rep(i, 1, opp_C) Ways[ddd[i]].pos /= All;
 	
 	Pro now = emptyPro;
-	rep(i, 1, opp_C) now.d[Ways[ddd[i]].act[1]+1] += Ways[ddd[i]].pos;
+	rep(i, 1, opp_C) now.d[Ways[ddd[i]].step[1].act+1] += Ways[ddd[i]].pos;
 	
 	
-#ifndef _BOTZONE_ONLINE
+#if !defined(_BOTZONE_ONLINE) && !defined(_PACMAN_LIBRARY)
 	rep(i, 0, 4) printf("%.5lf%c", now.d[i], i==4?'\n':' ');
 #endif
 	
 	
 	
+	Pacman::Direction action = Final(now);
+	ProfileLap(PF_FINAL);
+	
 	DealWithOutputData();
+	SaveGlobalData();
+	ProfileLap(PF_DATA);
+	
+	Ds("turn"); Di(gameField.turnID); Ds("action"); Di(action); Ds("depth"); Di(Depth); Dn();
+	Ds("pro"); rep(i, 0, 4) Dd(now.d[i]); Dn();
+	Ds("fight"); Di(FightMX); rep(i, 0, 8) Dd(Point[i]); Dn();
+#if !defined(_PACMAN_NO_PROFILE) && !defined(_PACMAN_NO_LOG)
+	WriteProfile(Log);
+#endif
 	
-#ifdef _BOTZONE_ONLINE
-	Ds("Round"); Di(gameField.turnID); Dn();
-	globalData += data; Dn();
+	
+	return action;
+}
+
+#ifdef _PACMAN_LIBRARY
+// 进程内调用的决策接口，省去启动进程和解析 JSON 历史，供自对弈和调参使用
+// field 是含历史的当前局面，playerID 是自己的编号，state/globalState 是上回合保存的 data/globaldata，返回时换成本回合要保存的
+// 随机数状态 RR 跨调用延续，需要复现时由调用者设置
+Pacman::Direction BotDecide(const Pacman::GameField &field, int playerID, string &state, string &globalState)
+{
+	ResetBot();
+	if (&field != &gameField)
+		gameField = field;
+	myID = playerID;
+	data.swap(state), globalData.swap(globalState);
+	Pacman::Direction action = Decide();
+	data.swap(state), globalData.swap(globalState);
+	return action;
+}
 #else
-	globalData = "";
+int main()
+{
+	ResetBot();
+	
+	myID = gameField.ReadInput("input.txt", data, globalData); // 输入，并获得自己ID
+	ProfileLap(PF_READ);
+	
+	rep(i, 1, 50) Rand();
+	
+	Pacman::Direction action = Decide();
+	
+	gameField.WriteOutput(action, DaCall(gameField.turnID), data, globalData, Log.len ? Log.buf : NULL, Log.len);
+	ProfileLap(PF_WRITE);
+	
+#if defined(_PACMAN_PROFILE_FILE) && !defined(_PACMAN_NO_PROFILE)
+	// 编译时定义 _PACMAN_PROFILE_FILE 则另把含输出耗时的完整记录追加到 profile.txt
+	static DebugLog record;
+	WriteProfile(record);
+	if (FILE *f = fopen("profile.txt", "a"))
+		fwrite(record.buf, 1, record.len, f), fclose(f);
 #endif
-	gameField.WriteOutput(Final(now), DaCall(gameField.turnID), data, globalData);
 	
 	
 	return 0;
-}
\ No newline at end of file
+}
+#endif
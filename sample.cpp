@@ -40,6 +40,9 @@
 #include <cstring>
 #include <stack>
 #include <stdexcept>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "jsoncpp/json.h"
 
 #define FIELD_MAX_HEIGHT 20
@@ -48,6 +51,20 @@
 #define MAX_PLAYER_COUNT 4
 #define MAX_TURN 100
 
+// 随机模拟的时间预算（毫秒，从程序启动算起）和线程数；平台上只有一个核，本地默认用满所有核
+// 在 arena 里用 -j 并行多局时（每局绑定一个核），请用 -DSAMPLE_THREADS=1 编译
+#ifndef SAMPLE_TIME_BUDGET
+#define SAMPLE_TIME_BUDGET 800
+#endif
+#ifndef SAMPLE_THREADS
+#ifdef _BOTZONE_ONLINE
+#define SAMPLE_THREADS 1
+#else
+#define SAMPLE_THREADS 0 // 0 表示 std::thread::hardware_concurrency()
+#endif
+#endif
+#define SAMPLE_MAX_THREADS 64
+
 // 你也可以选用 using namespace std; 但是会污染命名空间
 using std::string;
 using std::swap;
@@ -166,8 +183,7 @@ namespace Pacman
 	{
 		FieldProp newFruits[MAX_GENERATOR_COUNT * 8];
 		int newFruitCount;
-	} newFruits[MAX_TURN];
-	int newFruitsCount = 0;
+	};
 
 	// 状态转移记录结构
 	struct TurnStateTransfer
@@ -221,6 +237,8 @@ namespace Pacman
 		int turnID;
 		FieldProp generators[MAX_GENERATOR_COUNT]; // 有哪些豆子产生器
 		Player players[MAX_PLAYER_COUNT]; // 有哪些玩家
+		NewFruits newFruits[MAX_TURN]; // 每次产生的豆子（栈），恢复状态时收回；放在对象里，各线程的副本互不干扰
+		int newFruitsCount;
 
 										  // 玩家选定的动作
 		Direction actions[MAX_PLAYER_COUNT];
@@ -807,9 +825,11 @@ namespace Pacman
 			constructed = true;
 
 			turnID = 0;
+			newFruitsCount = 0;
 		}
 
-		GameField(const GameField &b) : GameField() { }
+		// 副本供各线程独立演算，不算新的对象
+		GameField(const GameField &b) = default;
 	};
 
 	bool GameField::constructed = false;
@@ -819,16 +839,38 @@ namespace Pacman
 namespace Helpers
 {
 
-	double actionScore[9] = {};
+	// 每个线程各自的随机数发生器（xorshift32），不共用 rand() 的全局状态
+	struct Random
+	{
+		unsigned int x;
 
-	inline int RandBetween(int a, int b)
+		explicit Random(unsigned int seed) : x(seed * 2654435761u + 0x9e3779b9u)
+		{
+			if (!x)
+				x = 1;
+		}
+		inline unsigned int Next()
+		{
+			x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+			return x;
+		}
+	};
+
+	// 每个线程的统计结果，按缓存行对齐以免线程间伪共享（放在静态数组里，C++17 之前 std::vector 不保证这种对齐）
+	struct alignas(64) PlayResult
+	{
+		double actionScore[9];
+		int count;
+	};
+
+	inline int RandBetween(Random &random, int a, int b)
 	{
 		if (a > b)
 			swap(a, b);
-		return rand() % (b - a) + a;
+		return random.Next() % (b - a) + a;
 	}
 
-	void RandomPlay(Pacman::GameField &gameField, int myID)
+	void RandomPlay(Pacman::GameField &gameField, int myID, Random &random, PlayResult &result)
 	{
 		int count = 0, myAct = -1;
 		while (true)
@@ -843,7 +885,7 @@ namespace Helpers
 				for (Pacman::Direction d = Pacman::stay; d < 8; ++d)
 					if (gameField.ActionValid(i, d))
 						valid[vCount++] = d;
-				gameField.actions[i] = valid[RandBetween(0, vCount)];
+				gameField.actions[i] = valid[RandBetween(random, 0, vCount)];
 			}
 
 			if (count == 0)
@@ -865,16 +907,28 @@ namespace Helpers
 			total += gameField.players[_].strength;
 
 		if (total != 0)
-			actionScore[myAct + 1] += (10000 * gameField.players[myID].strength / total) / 100.0;
+			result.actionScore[myAct + 1] += (10000 * gameField.players[myID].strength / total) / 100.0;
+		result.count++;
 
 		// 恢复游戏状态到最初（就是本回合）
 		while (count-- > 0)
 			gameField.PopState();
 	}
+
+	// 一个线程：在自己的局面副本上不断随机模拟，直到 deadline（至少模拟一局）
+	void PlayUntil(Pacman::GameField gameField, int myID, unsigned int seed,
+		std::chrono::steady_clock::time_point deadline, PlayResult *result)
+	{
+		Random random(seed);
+		do
+			RandomPlay(gameField, myID, random, *result);
+		while (std::chrono::steady_clock::now() < deadline);
+	}
 }
 
 int main()
 {
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SAMPLE_TIME_BUDGET);
 	Pacman::GameField gameField;
 	string data, globalData; // 这是回合之间可以传递的信息
 
@@ -884,12 +938,26 @@ int main()
 	srand(Pacman::seed + myID);
 
 	// 简单随机，看哪个动作随机赢得最多
-	for (int i = 0; i < 1000; i++)
-		Helpers::RandomPlay(gameField, myID);
+	// 每个线程有自己的局面副本和随机数发生器，时间到了再汇总；只有一个线程时就在主线程里跑
+	int threads = SAMPLE_THREADS ? SAMPLE_THREADS : std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min(threads, SAMPLE_MAX_THREADS);
+	static Helpers::PlayResult results[SAMPLE_MAX_THREADS];
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.push_back(std::thread(Helpers::PlayUntil, gameField, myID, (unsigned int)(Pacman::seed * MAX_PLAYER_COUNT + myID) * 131 + t,
+			deadline, &results[t]));
+	Helpers::PlayUntil(gameField, myID, (unsigned int)(Pacman::seed * MAX_PLAYER_COUNT + myID) * 131, deadline, &results[0]);
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	double actionScore[9] = {};
+	for (int t = 0; t < threads; t++)
+		for (int d = 0; d < 9; d++)
+			actionScore[d] += results[t].actionScore[d];
 
 	int maxD = 0, d;
 	for (d = 0; d < 8; d++)
-		if (Helpers::actionScore[d] > Helpers::actionScore[maxD])
+		if (actionScore[d] > actionScore[maxD])
 			maxD = d;
 
 	// 输出当前游戏局面状态以供本地调试。注意提交到平台上会自动优化掉，不必担心。
@@ -0,0 +1,450 @@
+/*
+* 本地对战平台：用 Pacman::GameField 当裁判，按 Botzone 的 JSON 协议驱动四个 Bot 进程
+* 和平台一样每回合重新启动 Bot、喂给它完整的历史，超时、崩溃或输出非法动作的 Bot 当回合被判死
+* 编译：g++ -O2 tools/arena.cpp -o arena
+* 用法：arena [-n 局数] [-j 并行局数] [-s 种子] [-m 地图.json] [-t 每回合毫秒] [-f 首回合毫秒] [-r 回放目录] bot0 bot1 bot2 bot3
+*  -j 个工作进程各自领取对局并绑定到不同的 CPU 上（Bot 进程继承绑定），结束后按 Bot 的路径汇总：
+*  胜率和平均力量带 95% 置信区间，另给出每回合用时的 p50/p99/最大值
+*  -r 给出时每局写 game-局号.json（含用时和调试输出）和 game-局号.pmr（replay.h 格式）两份回放
+*  -m 给出的地图是平台第一条 request 的格式（height/width/static/content 和四个参数），不给就用 mapgen.h 按种子生成
+*  每局把座位轮换一格，Bot 的 globaldata 在同一个工作进程下的各局之间保留
+*  Bot 以可执行文件路径直接启动（不经过 shell），标准输入是一行 JSON；本地编译的 main.cpp 会先读当前目录的
+*  input.txt，所以请在没有 input.txt 的目录下运行，或者用 -D_BOTZONE_ONLINE 编译 Bot
+*/
+
+#define _PACMAN_LIBRARY
+#include "../main.cpp"
+#include "mapgen.h"
+#include "replay.h"
+
+#include <chrono>
+#include <cerrno>
+#include <fcntl.h>
+#include <cmath>
+#include <map>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+// 一次 Bot 运行的结果
+struct BotRun
+{
+	string output;
+	long long micros;
+	bool timeout, crashed;
+};
+
+// 以 input 为标准输入运行一次 Bot，超过 limitMs 毫秒就杀掉；stderr 丢弃
+static BotRun RunBot(const char *path, const string &input, int limitMs)
+{
+	BotRun run;
+	run.micros = 0, run.timeout = run.crashed = false;
+
+	// 输入先写进临时文件，这样 Bot 不读标准输入时也不会卡住这边
+	char name[] = "/tmp/pacman-arena-XXXXXX";
+	int in = mkstemp(name), out[2];
+	if (in < 0 || pipe(out) < 0)
+		throw runtime_error("无法创建 Bot 的输入输出");
+	unlink(name);
+	for (size_t done = 0; done < input.size(); )
+	{
+		ssize_t n = write(in, input.data() + done, input.size() - done);
+		if (n <= 0)
+			throw runtime_error("无法写入 Bot 的输入");
+		done += n;
+	}
+	lseek(in, 0, SEEK_SET);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		int null = open("/dev/null", O_WRONLY);
+		dup2(in, 0), dup2(out[1], 1), dup2(null, 2);
+		close(in), close(out[0]), close(out[1]), close(null);
+		execl(path, path, (char *)NULL);
+		_exit(127);
+	}
+	close(in), close(out[1]);
+	if (pid < 0)
+	{
+		close(out[0]);
+		run.crashed = true;
+		return run;
+	}
+
+	char buf[65536];
+	while (true)
+	{
+		long long left = limitMs * 1000ll - std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+		if (left <= 0)
+		{
+			run.timeout = true;
+			kill(pid, SIGKILL);
+			break;
+		}
+		pollfd p = { out[0], POLLIN, 0 };
+		int r = poll(&p, 1, (int)((left + 999) / 1000));
+		if (r <= 0)
+			continue;
+		ssize_t n = read(out[0], buf, sizeof(buf));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		run.output.append(buf, n);
+	}
+	close(out[0]);
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	run.micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+	if (!run.timeout && !(WIFEXITED(status) && WEXITSTATUS(status) == 0))
+		run.crashed = true;
+	return run;
+}
+
+// 参赛的 Bot：路径和跨局保留的 globaldata，每个工作进程各有一份
+struct Bot
+{
+	const char *path;
+	string globalData;
+};
+static Bot bots[MAX_PLAYER_COUNT];
+
+// 下一局第 i 个座位上是 bots[seats[i]]
+static int seats[MAX_PLAYER_COUNT];
+
+// 用 gameField 下一整局，replay 得到完整的 JSON 回放（含用时和调试输出），binary 得到 replay.h 格式的回放
+// 每次运行 Bot 向 report 写一行“turn 编号 微秒 结果”，终局写一行“game 局号 种子 高 宽 回合数”加各座位的“编号 力量”
+static void PlayGame(int g, unsigned int seed, const PacmanMap &fieldMap, int limitMs, int firstLimitMs, Json::Value &replay, ReplayWriter &binary, FILE *report)
+{
+	Pacman::GameField &field = gameField;
+	fieldMap.Apply(field);
+	binary.Begin(fieldMap, field);
+	Json::Value map = fieldMap.ToJson();
+
+	Json::Value input[MAX_PLAYER_COUNT];
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+	{
+		Json::Value first = map;
+		first["id"] = i;
+		input[i]["requests"].append(first);
+		input[i]["responses"] = Json::Value(Json::arrayValue);
+		input[i]["data"] = "";
+	}
+
+	replay = Json::Value();
+	replay["seed"] = seed;
+	replay["initdata"] = map;
+	replay["log"] = Json::Value(Json::arrayValue);
+	Json::FastWriter writer;
+
+	bool running = true;
+	while (running)
+	{
+		Json::Value request, record;
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		{
+			Bot &bot = bots[seats[i]];
+			if (field.players[i].dead)
+				continue;
+
+			input[i]["globaldata"] = bot.globalData;
+			BotRun run = RunBot(bot.path, writer.write(input[i]), field.turnID ? limitMs : firstLimitMs);
+
+			// 平台只认 JSON；本地编译的 Bot 可能先打印调试信息，所以从第一个 { 开始解析
+			const char *verdict = "OK";
+			Json::Value output;
+			int action = 8;
+			size_t start = run.output.find('{');
+			if (run.timeout)
+				verdict = "TLE";
+			else if (run.crashed)
+				verdict = "RE";
+			else if (start == string::npos || !Json::Reader().parse(run.output.substr(start), output) || !output.isObject())
+				verdict = "BAD";
+			else
+			{
+				const Json::Value &response = output["response"];
+				const Json::Value &value = response.isObject() ? response["action"] : response;
+				if (value.isInt())
+					action = value.asInt();
+				else
+					verdict = "BAD";
+				input[i]["responses"].append(response);
+				input[i]["data"] = output["data"].asString();
+				if (output.isMember("globaldata"))
+					bot.globalData = output["globaldata"].asString();
+			}
+			fprintf(report, "turn %d %lld %s\n", seats[i], run.micros, verdict);
+
+			// 不合法的动作由 NextTurn 判死
+			field.actions[i] = (Pacman::Direction)action;
+			request[Pacman::playerID2str[i]]["action"] = action;
+			Json::Value &entry = record[Pacman::playerID2str[i]];
+			entry["action"] = action;
+			entry["time"] = (Json::Int64)run.micros;
+			entry["verdict"] = verdict;
+			if (output.isMember("debug"))
+				entry["debug"] = output["debug"];
+		}
+
+		running = field.NextTurn();
+		binary.Turn(field);
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			input[i]["requests"].append(request);
+		replay["log"].append(record);
+	}
+
+	fprintf(report, "game %d %u %d %d %d", g, seed, field.height, field.width, field.turnID);
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+	{
+		fprintf(report, " %d %d", seats[i], field.players[i].strength);
+		replay["scores"].append(field.players[i].strength);
+		replay["bots"].append(bots[seats[i]].path);
+	}
+	fprintf(report, "\n");
+	fflush(report);
+}
+
+// 同一路径的 Bot（可能坐了好几个座位）的汇总
+struct Build
+{
+	string path;
+	int seats, wins, timeouts, crashes, badOutputs;
+	double strength, strength2, rankSum;
+	std::vector<long long> micros;
+
+	Build() : seats(0), wins(0), timeouts(0), crashes(0), badOutputs(0), strength(0), strength2(0), rankSum(0) { }
+};
+
+// 成功率 wins/n 的 95% Wilson 置信区间
+static void Wilson(int wins, int n, double &low, double &high)
+{
+	const double z = 1.96;
+	if (n == 0)
+	{
+		low = 0, high = 1;
+		return;
+	}
+	double p = (double)wins / n, d = 1 + z * z / n;
+	double center = (p + z * z / (2 * n)) / d, half = z * std::sqrt(p * (1 - p) / n + z * z / (4.0 * n * n)) / d;
+	low = center - half, high = center + half;
+}
+
+// 已排序样本的 q 分位数（最近秩）
+static double Percentile(const std::vector<long long> &sorted, double q)
+{
+	if (sorted.empty())
+		return 0;
+	size_t k = (size_t)std::ceil(q * sorted.size());
+	return (double)sorted[k ? k - 1 : 0];
+}
+
+// 处理工作进程汇报的一行
+static void Collect(const char *line, Build *slot[])
+{
+	int g, H, W, turns, n, who, strength[MAX_PLAYER_COUNT], seat[MAX_PLAYER_COUNT];
+	unsigned int seed;
+	long long micros;
+	char verdict[8];
+	if (sscanf(line, "turn %d %lld %7s", &who, &micros, verdict) == 3)
+	{
+		Build &b = *slot[who];
+		b.micros.push_back(micros);
+		b.timeouts += !strcmp(verdict, "TLE");
+		b.crashes += !strcmp(verdict, "RE");
+		b.badOutputs += !strcmp(verdict, "BAD");
+	}
+	else if (sscanf(line, "game %d %u %d %d %d%n", &g, &seed, &H, &W, &turns, &n) == 5)
+	{
+		const char *p = line + n;
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		{
+			int used;
+			sscanf(p, " %d %d%n", &seat[i], &strength[i], &used);
+			p += used;
+		}
+		printf("game %d seed %u %dx%d turns %d |", g, seed, H, W, turns);
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		{
+			// 按力量排名，力量相同名次相同
+			int rank = 1;
+			for (int j = 0; j < MAX_PLAYER_COUNT; j++)
+				rank += strength[j] > strength[i];
+			Build &b = *slot[seat[i]];
+			b.seats++;
+			b.wins += rank == 1;
+			b.rankSum += rank;
+			b.strength += strength[i];
+			b.strength2 += (double)strength[i] * strength[i];
+			printf(" bot%d %d", seat[i], strength[i]);
+		}
+		putchar('\n');
+		fflush(stdout);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int games = 1, jobs = 1, limitMs = 1000, firstLimitMs = 2000, opt;
+	unsigned int seed = (unsigned int)time(0);
+	const char *mapFile = NULL, *replayDir = NULL;
+	while ((opt = getopt(argc, argv, "n:j:s:m:t:f:r:")) != -1)
+		switch (opt)
+		{
+		case 'n': games = atoi(optarg); break;
+		case 'j': jobs = std::max(atoi(optarg), 1); break;
+		case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+		case 'm': mapFile = optarg; break;
+		case 't': limitMs = atoi(optarg); break;
+		case 'f': firstLimitMs = atoi(optarg); break;
+		case 'r': replayDir = optarg; break;
+		default: return 2;
+		}
+	if (argc - optind != MAX_PLAYER_COUNT)
+	{
+		fprintf(stderr, "用法：%s [-n 局数] [-j 并行局数] [-s 种子] [-m 地图.json] [-t 每回合毫秒] [-f 首回合毫秒] [-r 回放目录] bot0 bot1 bot2 bot3\n", argv[0]);
+		return 2;
+	}
+
+	PacmanMap fixedMap;
+	if (mapFile)
+	{
+		std::ifstream fin(mapFile);
+		Json::Value map;
+		if (!fin || !Json::Reader().parse(fin, map) || !fixedMap.FromJson(map))
+		{
+			fprintf(stderr, "无法读取地图 %s\n", mapFile);
+			return 1;
+		}
+	}
+
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		bots[i].path = argv[optind + i];
+	jobs = std::min(jobs, std::max(games, 1));
+
+	// 下一个待领取的局号放在共享内存里，工作进程用原子加领取
+	int *nextGame = (int *)mmap(NULL, sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (nextGame == MAP_FAILED)
+		throw runtime_error("无法分配共享内存");
+	*nextGame = 0;
+
+	std::vector<int> reports;
+	std::vector<pid_t> workers;
+	int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	for (int w = 0; w < jobs; w++)
+	{
+		int fd[2];
+		if (pipe(fd) < 0)
+			throw runtime_error("无法创建工作进程的管道");
+		fflush(stdout);
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			close(fd[0]);
+			for (size_t i = 0; i < reports.size(); i++)
+				close(reports[i]);
+#ifdef __linux__
+			if (jobs > 1 && cpus > 1)
+			{
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				CPU_SET(w % cpus, &set);
+				sched_setaffinity(0, sizeof(set), &set);
+			}
+#endif
+			FILE *report = fdopen(fd[1], "w");
+			for (int g; (g = __sync_fetch_and_add(nextGame, 1)) < games; )
+			{
+				unsigned int gameSeed = seed + g;
+				PacmanMap map = mapFile ? fixedMap : GenerateMap(gameSeed);
+				Json::Value replay;
+				ReplayWriter binary;
+				for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+					seats[i] = (i + g) % MAX_PLAYER_COUNT;
+
+				PlayGame(g, gameSeed, map, limitMs, firstLimitMs, replay, binary, report);
+
+				if (replayDir)
+				{
+					char name[4096];
+					snprintf(name, sizeof(name), "%s/game-%d.json", replayDir, g);
+					std::ofstream(name) << Json::FastWriter().write(replay);
+					snprintf(name, sizeof(name), "%s/game-%d.pmr", replayDir, g);
+					binary.Save(name, gameField);
+				}
+			}
+			fclose(report);
+			_exit(0);
+		}
+		close(fd[1]);
+		if (pid < 0)
+			throw runtime_error("无法创建工作进程");
+		reports.push_back(fd[0]);
+		workers.push_back(pid);
+	}
+
+	// 同一路径的 Bot 汇总到一起
+	std::map<string, Build> builds;
+	Build *slot[MAX_PLAYER_COUNT];
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+	{
+		slot[i] = &builds[bots[i].path];
+		slot[i]->path = bots[i].path;
+	}
+
+	// 逐行收集各工作进程的汇报
+	std::vector<string> pending(jobs);
+	std::vector<pollfd> fds(jobs);
+	for (int w = 0; w < jobs; w++)
+		fds[w].fd = reports[w], fds[w].events = POLLIN;
+	for (int open = jobs; open; )
+	{
+		if (poll(&fds[0], jobs, -1) < 0)
+			continue;
+		for (int w = 0; w < jobs; w++)
+			if (fds[w].fd >= 0 && fds[w].revents)
+			{
+				char buf[65536];
+				ssize_t n = read(fds[w].fd, buf, sizeof(buf));
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n <= 0)
+				{
+					close(fds[w].fd);
+					fds[w].fd = -1, open--;
+					continue;
+				}
+				string &line = pending[w];
+				for (ssize_t i = 0; i < n; i++)
+					if (buf[i] == '\n')
+						Collect(line.c_str(), slot), line.clear();
+					else
+						line += buf[i];
+			}
+	}
+	for (int w = 0; w < jobs; w++)
+		waitpid(workers[w], NULL, 0);
+
+	printf("%-24s %6s %6s %15s %9s %9s %6s %8s %8s %8s %4s %4s %4s\n", "build", "seats", "win%", "95% CI", "strength", "+-95%", "rank",
+		"p50(ms)", "p99(ms)", "max(ms)", "TLE", "RE", "BAD");
+	for (std::map<string, Build>::iterator it = builds.begin(); it != builds.end(); ++it)
+	{
+		Build &b = it->second;
+		int n = std::max(b.seats, 1);
+		double low, high, mean = b.strength / n, var = std::max(b.strength2 / n - mean * mean, 0.0);
+		Wilson(b.wins, b.seats, low, high);
+		std::sort(b.micros.begin(), b.micros.end());
+		char ci[32];
+		snprintf(ci, sizeof(ci), "[%.1f, %.1f]", 100 * low, 100 * high);
+		printf("%-24s %6d %6.1f %15s %9.2f %9.2f %6.2f %8.2f %8.2f %8.2f %4d %4d %4d\n", b.path.c_str(), b.seats,
+			100.0 * b.wins / n, ci, mean, b.seats > 1 ? 1.96 * std::sqrt(var * n / (n - 1) / n) : 0.0,
+			b.rankSum / n, Percentile(b.micros, 0.5) / 1000, Percentile(b.micros, 0.99) / 1000,
+			b.micros.empty() ? 0.0 : b.micros.back() / 1000.0, b.timeouts, b.crashes, b.badOutputs);
+	}
+	return 0;
+}
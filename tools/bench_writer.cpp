@@ -0,0 +1,85 @@
+/*
+* 回复生成的微基准：比较 Pacman::ResponseWriter 与 Json::FastWriter / Json::StyledWriter
+* 编译：g++ -O2 tools/bench_writer.cpp -o bench_writer
+* 用法：bench_writer [每种长度的重复次数]
+*/
+
+#define _PACMAN_LIBRARY
+#include "../main.cpp"
+
+#include <chrono>
+
+// 构造和 DealWithOutputData 产生的 data 相似的文本：数字、空格和换行
+static string MakeData(size_t len)
+{
+	string s;
+	unsigned int r = 1;
+	while (s.size() < len)
+	{
+		r = r * 1103515245 + 12345;
+		s += (char)('0' + r % 10);
+		s += (r >> 8) % 6 ? ' ' : '\n';
+	}
+	return s;
+}
+
+template<typename F>
+static double Measure(int repeat, F f)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < repeat; i++)
+		f();
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / repeat;
+}
+
+int main(int argc, char **argv)
+{
+	int repeat = argc > 1 ? atoi(argv[1]) : 2000;
+	const size_t lengths[] = { 256, 1024, 4096, 16384, 65536 };
+	Pacman::ResponseWriter direct;
+	volatile size_t sink = 0;
+
+	printf("%8s %12s %12s %12s\n", "bytes", "direct(us)", "fast(us)", "styled(us)");
+	for (size_t k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++)
+	{
+		string data = MakeData(lengths[k]), globalData = MakeData(lengths[k] / 2), taunt = "START:DASH!";
+
+		// 两种生成器的结果必须一致
+		Json::Value ret;
+		ret["response"]["action"] = 2;
+		ret["response"]["tauntText"] = taunt;
+		ret["data"] = data;
+		ret["globaldata"] = globalData;
+		ret["debug"] = 1478417566;
+		size_t len = direct.Format(2, taunt, data, globalData, 1478417566);
+		if (string(direct.Buffer(), len) != Json::FastWriter().write(ret))
+		{
+			puts("ResponseWriter 与 Json::FastWriter 的结果不一致");
+			return 1;
+		}
+
+		double tDirect = Measure(repeat, [&]() { sink += direct.Format(2, taunt, data, globalData, 1478417566); });
+		double tFast = Measure(repeat, [&]()
+		{
+			Json::Value v;
+			v["response"]["action"] = 2;
+			v["response"]["tauntText"] = taunt;
+			v["data"] = data;
+			v["globaldata"] = globalData;
+			v["debug"] = 1478417566;
+			sink += Json::FastWriter().write(v).size();
+		});
+		double tStyled = Measure(repeat, [&]()
+		{
+			Json::Value v;
+			v["response"]["action"] = 2;
+			v["response"]["tauntText"] = taunt;
+			v["data"] = data;
+			v["globaldata"] = globalData;
+			v["debug"] = 1478417566;
+			sink += Json::StyledWriter().write(v).size();
+		});
+		printf("%8d %12.3f %12.3f %12.3f\n", (int)lengths[k], tDirect, tFast, tStyled);
+	}
+	return 0;
+}
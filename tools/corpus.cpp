@@ -0,0 +1,154 @@
+/*
+* 局面库（corpus.h）的导出和检查
+* 编译：g++ -O2 tools/corpus.cpp -o corpus
+* 用法：
+*  corpus -o 局面.pmc 回放.pmr|输入.json...  把回放或平台给 Bot 的输入（requests 历史）中每回合的局面导出
+*  corpus 局面.pmc                           打印概况，校验相邻局面演算一致，并统计载入速度
+*/
+
+#define _PACMAN_LIBRARY
+#include "../main.cpp"
+#include "mapgen.h"
+#include "replay.h"
+#include "corpus.h"
+
+#include <chrono>
+
+// 从第 0 回合起按 actions（每回合四个）演算一局，逐回合写入局面库
+static bool ExportGame(CorpusWriter &writer, const PacmanMap &map, const std::vector<int> &actions)
+{
+	map.Apply(gameField);
+	uint32_t game = writer.Game(), index = writer.Map(map);
+	std::vector<CorpusPosition> positions;
+	for (size_t t = 0; t < actions.size() / MAX_PLAYER_COUNT; t++)
+	{
+		positions.push_back(CorpusCapture(gameField, game, index));
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		{
+			gameField.actions[i] = gameField.players[i].dead ? Pacman::stay : (Pacman::Direction)actions[t * MAX_PLAYER_COUNT + i];
+			positions.back().actions[i] = (int8_t)gameField.actions[i];
+		}
+		if (!gameField.NextTurn())
+			break;
+	}
+	for (size_t t = 0; t < positions.size(); t++)
+	{
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			positions[t].finalStrength[i] = gameField.players[i].strength;
+		if (!writer.Add(positions[t]))
+			return false;
+	}
+	return true;
+}
+
+// 读入回放或平台输入，得到地图和逐回合的动作
+static bool ReadGame(const char *path, PacmanMap &map, std::vector<int> &actions)
+{
+	actions.clear();
+	ReplayReader reader;
+	if (reader.Load(path))
+	{
+		map = reader.Map();
+		for (int t = 0; t < reader.Turns(); t++)
+			for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+				actions.push_back(reader.Action(t, i));
+		return true;
+	}
+
+	std::ifstream fin(path);
+	Json::Value root;
+	if (!fin || !Json::Reader().parse(fin, root) || !map.FromJson(root["requests"][0u]))
+		return false;
+	for (Json::ArrayIndex t = 1; t < root["requests"].size(); t++)
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			actions.push_back(root["requests"][t][Pacman::playerID2str[i]]["action"].asInt());
+	return true;
+}
+
+static int Export(const char *output, int count, char **inputs)
+{
+	CorpusWriter writer;
+	if (!writer.Open(output))
+	{
+		fprintf(stderr, "无法写入 %s\n", output);
+		return 1;
+	}
+	int skipped = 0;
+	for (int f = 0; f < count; f++)
+	{
+		PacmanMap map;
+		std::vector<int> actions;
+		if (!ReadGame(inputs[f], map, actions))
+		{
+			fprintf(stderr, "无法读取 %s，跳过\n", inputs[f]);
+			skipped++;
+			continue;
+		}
+		if (!ExportGame(writer, map, actions))
+		{
+			fprintf(stderr, "无法写入 %s\n", output);
+			return 1;
+		}
+	}
+	if (!writer.Close())
+	{
+		fprintf(stderr, "无法写入 %s\n", output);
+		return 1;
+	}
+	return skipped ? 1 : 0;
+}
+
+static int Inspect(const char *path)
+{
+	PositionCorpus corpus;
+	if (!corpus.Open(path))
+	{
+		fprintf(stderr, "无法读取局面库 %s\n", path);
+		return 1;
+	}
+	printf("%u positions, %u games, %u maps, %u bytes/position\n", corpus.Count(), corpus.GameCount(), corpus.MapCount(),
+		(unsigned int)sizeof(CorpusPosition));
+
+	// 同一局的相邻局面：前一个按记录的动作演算一回合应当得到后一个
+	static Pacman::GameField next;
+	PositionCorpus check;
+	check.Open(path);
+	int bad = 0;
+	for (uint32_t i = 0; i + 1 < corpus.Count(); i++)
+		if (corpus[i].game == corpus[i + 1].game)
+		{
+			corpus.Load(i, gameField);
+			for (int p = 0; p < MAX_PLAYER_COUNT; p++)
+				gameField.actions[p] = (Pacman::Direction)corpus[i].actions[p];
+			gameField.NextTurn();
+			check.Load(i + 1, next);
+			if (!SameState(gameField, next))
+			{
+				if (bad < 10)
+					printf("第 %u 局第 %d 回合不一致\n", corpus[i].game, corpus[i].turnID);
+				bad++;
+			}
+		}
+
+	long long loads = 0;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	do
+		for (uint32_t i = 0; i < corpus.Count(); i++, loads++)
+			corpus.Load(i, gameField);
+	while (std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() < 0.5 && corpus.Count());
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	printf("%d bad, %.0f loads/s\n", bad, loads / seconds);
+	return bad ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 4 && !strcmp(argv[1], "-o"))
+		return Export(argv[2], argc - 3, argv + 3);
+	if (argc != 2)
+	{
+		fprintf(stderr, "用法：%s -o 局面.pmc 回放.pmr|输入.json... | 局面.pmc\n", argv[0]);
+		return 2;
+	}
+	return Inspect(argv[1]);
+}
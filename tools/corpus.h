@@ -0,0 +1,296 @@
+/*
+* 局面库：大量局面存成定长记录的二进制文件，mmap 之后直接按下标访问，不需要解析，供基准测试和调参批量评估
+* 需要在 #include "../main.cpp" 和 "mapgen.h" 之后包含
+*
+* 文件格式（整数均为本机字节序，文件头里的版本和记录长度对不上就拒绝打开）：
+*  文件头 CorpusHeader
+*  局面：recordCount 个 CorpusPosition，按对局、回合排列
+*  地图：mapCount 个 CorpusMap，相同的地图只存一份，局面用下标引用
+* 每个局面是某局第 turnID 回合开始时的状态，附带这回合各玩家实际的动作和这局的终局力量
+*/
+
+#ifndef PACMAN_CORPUS_H
+#define PACMAN_CORPUS_H
+
+#include <fcntl.h>
+#include <map>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CORPUS_VERSION 1
+
+struct CorpusHeader
+{
+	char magic[4]; // "PMPC"
+	uint32_t version, recordSize, mapSize;
+	uint32_t recordCount, mapCount, gameCount;
+};
+
+// 地图中不随回合变化的部分
+struct CorpusMap
+{
+	uint8_t height, width, padding[2];
+	int32_t GENERATOR_INTERVAL, LARGE_FRUIT_DURATION, LARGE_FRUIT_ENHANCEMENT, SKILL_COST;
+	uint8_t fieldStatic[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
+};
+
+struct CorpusPosition
+{
+	uint32_t game, map;
+	uint16_t turnID;
+	int8_t actions[MAX_PLAYER_COUNT]; // 这回合各玩家的动作，死亡的玩家为 stay
+	uint8_t aliveCount, padding;
+	int32_t generatorTurnLeft, smallFruitCount;
+	struct
+	{
+		uint8_t row, col, dead, padding;
+		int32_t strength, powerUpLeft;
+	} players[MAX_PLAYER_COUNT];
+	int32_t finalStrength[MAX_PLAYER_COUNT];
+
+	// 豆子的位掩码：第 r 行第 c 位，玩家的位置由 players 给出
+	uint32_t smallFruit[FIELD_MAX_HEIGHT], largeFruit[FIELD_MAX_HEIGHT];
+};
+
+static_assert(FIELD_MAX_WIDTH <= 32, "CorpusPosition 的一行豆子存在一个 uint32_t 里");
+static_assert(sizeof(CorpusPosition) % 4 == 0 && sizeof(CorpusMap) % 4 == 0, "记录要保持 4 字节对齐");
+
+// 从 field 取出当前局面，actions 和 finalStrength 由调用者填写
+inline CorpusPosition CorpusCapture(const Pacman::GameField &field, uint32_t game, uint32_t map)
+{
+	CorpusPosition p;
+	memset(&p, 0, sizeof(p));
+	p.game = game, p.map = map;
+	p.turnID = (uint16_t)field.turnID;
+	p.aliveCount = (uint8_t)field.aliveCount;
+	p.generatorTurnLeft = field.generatorTurnLeft;
+	p.smallFruitCount = field.smallFruitCount;
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+	{
+		const Pacman::Player &pl = field.players[i];
+		p.players[i].row = (uint8_t)pl.row, p.players[i].col = (uint8_t)pl.col, p.players[i].dead = pl.dead;
+		p.players[i].strength = pl.strength, p.players[i].powerUpLeft = pl.powerUpLeft;
+	}
+	for (int r = 0; r < field.height; r++)
+		for (int c = 0; c < field.width; c++)
+		{
+			if (field.fieldContent[r][c] & Pacman::smallFruit)
+				p.smallFruit[r] |= 1u << c;
+			if (field.fieldContent[r][c] & Pacman::largeFruit)
+				p.largeFruit[r] |= 1u << c;
+		}
+	return p;
+}
+
+// 顺序写出局面库：局面直接写入文件，地图去重后留在内存里，Close 时追加到末尾并补写文件头
+class CorpusWriter
+{
+	FILE *f;
+	CorpusHeader header;
+	std::vector<CorpusMap> maps;
+	std::map<string, uint32_t> mapIndex;
+
+public:
+	CorpusWriter() : f(NULL) {}
+	~CorpusWriter()
+	{
+		if (f)
+			fclose(f);
+	}
+
+	bool Open(const char *path)
+	{
+		f = fopen(path, "wb");
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "PMPC", 4);
+		header.version = CORPUS_VERSION;
+		header.recordSize = sizeof(CorpusPosition);
+		header.mapSize = sizeof(CorpusMap);
+		maps.clear();
+		mapIndex.clear();
+		return f && fwrite(&header, sizeof(header), 1, f) == 1;
+	}
+
+	// 返回地图的下标，已有的地图不重复存
+	uint32_t Map(const PacmanMap &m)
+	{
+		CorpusMap cm;
+		memset(&cm, 0, sizeof(cm));
+		cm.height = (uint8_t)m.height, cm.width = (uint8_t)m.width;
+		cm.GENERATOR_INTERVAL = m.GENERATOR_INTERVAL;
+		cm.LARGE_FRUIT_DURATION = m.LARGE_FRUIT_DURATION;
+		cm.LARGE_FRUIT_ENHANCEMENT = m.LARGE_FRUIT_ENHANCEMENT;
+		cm.SKILL_COST = m.SKILL_COST;
+		for (int r = 0; r < m.height; r++)
+			for (int c = 0; c < m.width; c++)
+				cm.fieldStatic[r][c] = (uint8_t)m.fieldStatic[r][c];
+		std::pair<std::map<string, uint32_t>::iterator, bool> it =
+			mapIndex.insert(std::make_pair(string((const char *)&cm, sizeof(cm)), (uint32_t)maps.size()));
+		if (it.second)
+			maps.push_back(cm);
+		return it.first->second;
+	}
+
+	// 新开一局，返回对局编号
+	uint32_t Game()
+	{
+		return header.gameCount++;
+	}
+
+	bool Add(const CorpusPosition &p)
+	{
+		header.recordCount++;
+		return fwrite(&p, sizeof(p), 1, f) == 1;
+	}
+
+	bool Close()
+	{
+		bool ok = maps.empty() || fwrite(&maps[0], sizeof(CorpusMap), maps.size(), f) == maps.size();
+		header.mapCount = (uint32_t)maps.size();
+		ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, f) == 1;
+		ok = fclose(f) == 0 && ok;
+		f = NULL;
+		return ok;
+	}
+};
+
+// 只读映射整个局面库
+class PositionCorpus
+{
+	void *base;
+	size_t length;
+	const CorpusHeader *header;
+	const CorpusPosition *records;
+	const CorpusMap *maps;
+
+	// field 的静态部分是否已经是地图 m：field 可能在两次 Load 之间被别的途径（ReplayReader::Seek、PacmanMap::Apply、BotDecide 等）
+	// 换过，所以逐项比较而不是记住上次载入的是哪张地图
+	static bool HasMap(const Pacman::GameField &field, const CorpusMap &m)
+	{
+		if (field.height != m.height || field.width != m.width || field.GENERATOR_INTERVAL != m.GENERATOR_INTERVAL ||
+			field.LARGE_FRUIT_DURATION != m.LARGE_FRUIT_DURATION || field.LARGE_FRUIT_ENHANCEMENT != m.LARGE_FRUIT_ENHANCEMENT ||
+			field.SKILL_COST != m.SKILL_COST)
+			return false;
+		for (int r = 0; r < m.height; r++)
+			for (int c = 0; c < m.width; c++)
+				if (field.fieldStatic[r][c] != m.fieldStatic[r][c])
+					return false;
+		return true;
+	}
+
+public:
+	PositionCorpus() : base(MAP_FAILED), length(0) {}
+	~PositionCorpus()
+	{
+		Close();
+	}
+
+	// 文件不存在或格式不对返回 false
+	bool Open(const char *path)
+	{
+		Close();
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(CorpusHeader))
+		{
+			length = st.st_size;
+			base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		if (base == MAP_FAILED)
+			return false;
+		madvise(base, length, MADV_SEQUENTIAL);
+
+		header = (const CorpusHeader *)base;
+		records = (const CorpusPosition *)(header + 1);
+		maps = (const CorpusMap *)(records + header->recordCount);
+		if (memcmp(header->magic, "PMPC", 4) || header->version != CORPUS_VERSION ||
+			header->recordSize != sizeof(CorpusPosition) || header->mapSize != sizeof(CorpusMap) ||
+			length != sizeof(CorpusHeader) + (size_t)header->recordCount * sizeof(CorpusPosition) + (size_t)header->mapCount * sizeof(CorpusMap))
+		{
+			Close();
+			return false;
+		}
+		for (uint32_t i = 0; i < header->mapCount; i++)
+			if (maps[i].height > FIELD_MAX_HEIGHT || maps[i].width > FIELD_MAX_WIDTH)
+			{
+				Close();
+				return false;
+			}
+		return true;
+	}
+
+	void Close()
+	{
+		if (base != MAP_FAILED)
+			munmap(base, length);
+		base = MAP_FAILED;
+	}
+
+	uint32_t Count() const
+	{
+		return header->recordCount;
+	}
+	uint32_t MapCount() const
+	{
+		return header->mapCount;
+	}
+	uint32_t GameCount() const
+	{
+		return header->gameCount;
+	}
+	const CorpusPosition &operator[](uint32_t i) const
+	{
+		return records[i];
+	}
+	const CorpusMap &Map(uint32_t i) const
+	{
+		return maps[i];
+	}
+
+	// 把 field 设为第 i 个局面，之后可以继续演算，但不能 PopState 到这个局面之前
+	// field 的静态部分已经是这张地图时（连续载入同一张地图的局面）不必重建
+	void Load(uint32_t i, Pacman::GameField &field)
+	{
+		const CorpusPosition &p = records[i];
+		const CorpusMap &m = maps[p.map];
+		if (!HasMap(field, m))
+		{
+			int s[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH], t[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
+			for (int r = 0; r < m.height; r++)
+				for (int c = 0; c < m.width; c++)
+					s[r][c] = m.fieldStatic[r][c], t[r][c] = 0;
+			field.height = m.height;
+			field.width = m.width;
+			field.GENERATOR_INTERVAL = m.GENERATOR_INTERVAL;
+			field.LARGE_FRUIT_DURATION = m.LARGE_FRUIT_DURATION;
+			field.LARGE_FRUIT_ENHANCEMENT = m.LARGE_FRUIT_ENHANCEMENT;
+			field.SKILL_COST = m.SKILL_COST;
+			field.SelectSimulator();
+			field.PrepareInitialField(s, t);
+		}
+
+		for (int r = 0; r < field.height; r++)
+			for (int c = 0; c < field.width; c++)
+				field.fieldContent[r][c] = (Pacman::GridContentType)
+					((p.smallFruit[r] >> c & 1 ? Pacman::smallFruit : 0) | (p.largeFruit[r] >> c & 1 ? Pacman::largeFruit : 0));
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		{
+			Pacman::Player &pl = field.players[i];
+			pl.row = p.players[i].row, pl.col = p.players[i].col, pl.dead = p.players[i].dead;
+			pl.strength = p.players[i].strength, pl.powerUpLeft = p.players[i].powerUpLeft;
+			if (!pl.dead)
+				field.fieldContent[pl.row][pl.col] = (Pacman::GridContentType)(field.fieldContent[pl.row][pl.col] | Pacman::playerID2Mask[i]);
+		}
+		field.turnID = p.turnID;
+		field.aliveCount = p.aliveCount;
+		field.generatorTurnLeft = p.generatorTurnLeft;
+		field.smallFruitCount = p.smallFruitCount;
+		field.newFruitsCount = 0;
+	}
+};
+
+#endif
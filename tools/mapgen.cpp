@@ -0,0 +1,41 @@
+/*
+* 批量生成地图：每行输出一张平台第一条 request 格式的地图（不含 id）
+* 编译：g++ -O2 tools/mapgen.cpp -o mapgen
+* 用法：mapgen [-n 张数] [-s 起始种子] [-p]
+*  第 i 张用种子 起始种子+i；-p 改为打印成便于查看的字符画
+*/
+
+#define _PACMAN_LIBRARY
+#include "../main.cpp"
+#include "mapgen.h"
+
+int main(int argc, char **argv)
+{
+	int count = 1, opt;
+	unsigned int seed = 1;
+	bool pretty = false;
+	while ((opt = getopt(argc, argv, "n:s:p")) != -1)
+		switch (opt)
+		{
+		case 'n': count = atoi(optarg); break;
+		case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+		case 'p': pretty = true; break;
+		default: return 2;
+		}
+
+	Json::FastWriter writer;
+	for (int i = 0; i < count; i++)
+	{
+		PacmanMap map = GenerateMap(seed + i);
+		if (pretty)
+		{
+			map.Apply(gameField);
+			gameField.DebugPrint();
+			printf("GENERATOR_INTERVAL %d LARGE_FRUIT_DURATION %d LARGE_FRUIT_ENHANCEMENT %d SKILL_COST %d\n\n",
+				map.GENERATOR_INTERVAL, map.LARGE_FRUIT_DURATION, map.LARGE_FRUIT_ENHANCEMENT, map.SKILL_COST);
+		}
+		else
+			fputs(writer.write(map.ToJson()).c_str(), stdout);
+	}
+	return 0;
+}
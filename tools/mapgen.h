@@ -0,0 +1,234 @@
+/*
+* 地图生成器：给定种子生成与平台同分布的场地，供对战平台、自对弈和基准测试使用
+* 需要在 #include "../main.cpp" 之后包含
+*
+* 生成规则：
+*  高、宽各在 [6, 12] 中随机，场地上下、左右都对称，边界循环相通
+*  墙：先全部封死，再按随机顺序成组（四个对称位置一组）拆墙，直到全图连通（随机 Kruskal），然后额外拆掉 MAPGEN_LOOP 比例的墙形成环路
+*  左上象限随机选出生点和产生器各一个，镜像到四个象限；0~3 号玩家依次在左上、右上、右下、左下
+*  其余格子按组以 MAPGEN_SMALL_FRUIT 的概率放小豆，另选 MAPGEN_LARGE_FRUIT 组放大豆
+*/
+
+#ifndef PACMAN_MAPGEN_H
+#define PACMAN_MAPGEN_H
+
+#define MAPGEN_MIN_SIZE 6
+#define MAPGEN_MAX_SIZE 12
+#define MAPGEN_LOOP 0.3
+#define MAPGEN_SMALL_FRUIT 0.3
+#define MAPGEN_LARGE_FRUIT 1
+
+// 平台的四个参数的取值范围（闭区间）
+#define MAPGEN_GENERATOR_INTERVAL 10, 20
+#define MAPGEN_LARGE_FRUIT_DURATION 10, 20
+#define MAPGEN_LARGE_FRUIT_ENHANCEMENT 5, 15
+#define MAPGEN_SKILL_COST 5, 15
+
+// 生成器自己的随机数（xorshift32），不影响 Bot 的 RR，各平台结果一致
+struct MapRandom
+{
+	unsigned int x;
+
+	// 种子先经过 murmur3 的混合函数，相邻的种子才不会得到相关的地图
+	explicit MapRandom(unsigned int seed) : x(seed + 0x9e3779b9u)
+	{
+		x ^= x >> 16, x *= 0x85ebca6bu, x ^= x >> 13, x *= 0xc2b2ae35u, x ^= x >> 16;
+		if (!x)
+			x = 1;
+	}
+	unsigned int Next()
+	{
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+		return x;
+	}
+	// [l, r] 中的整数
+	int Int(int l, int r)
+	{
+		return l + (int)(Next() % (unsigned int)(r - l + 1));
+	}
+	bool Chance(double p)
+	{
+		return Next() / 4294967296.0 < p;
+	}
+};
+
+// 平台第一条 request 所描述的场地
+struct PacmanMap
+{
+	int height, width;
+	int GENERATOR_INTERVAL, LARGE_FRUIT_DURATION, LARGE_FRUIT_ENHANCEMENT, SKILL_COST;
+	int fieldStatic[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH], fieldContent[FIELD_MAX_HEIGHT][FIELD_MAX_WIDTH];
+
+	// 转成平台第一条 request 的格式（不含 id）
+	Json::Value ToJson() const
+	{
+		Json::Value map;
+		map["height"] = height;
+		map["width"] = width;
+		for (int r = 0; r < height; r++)
+			for (int c = 0; c < width; c++)
+			{
+				map["static"][r][c] = fieldStatic[r][c];
+				map["content"][r][c] = fieldContent[r][c];
+			}
+		map["GENERATOR_INTERVAL"] = GENERATOR_INTERVAL;
+		map["LARGE_FRUIT_DURATION"] = LARGE_FRUIT_DURATION;
+		map["LARGE_FRUIT_ENHANCEMENT"] = LARGE_FRUIT_ENHANCEMENT;
+		map["SKILL_COST"] = SKILL_COST;
+		return map;
+	}
+
+	// 从平台第一条 request 的格式读入，尺寸不合法返回 false
+	bool FromJson(const Json::Value &map)
+	{
+		height = map["height"].asInt();
+		width = map["width"].asInt();
+		if (height <= 0 || height > FIELD_MAX_HEIGHT || width <= 0 || width > FIELD_MAX_WIDTH)
+			return false;
+		for (int r = 0; r < height; r++)
+			for (int c = 0; c < width; c++)
+			{
+				fieldStatic[r][c] = map["static"][r][c].asInt();
+				fieldContent[r][c] = map["content"][r][c].asInt();
+			}
+		GENERATOR_INTERVAL = map["GENERATOR_INTERVAL"].asInt();
+		LARGE_FRUIT_DURATION = map["LARGE_FRUIT_DURATION"].asInt();
+		LARGE_FRUIT_ENHANCEMENT = map["LARGE_FRUIT_ENHANCEMENT"].asInt();
+		SKILL_COST = map["SKILL_COST"].asInt();
+		return true;
+	}
+
+	// 把 field 设为这张地图的第 0 回合
+	void Apply(Pacman::GameField &field) const
+	{
+		field.turnID = 0;
+		field.height = height;
+		field.width = width;
+		field.GENERATOR_INTERVAL = GENERATOR_INTERVAL;
+		field.LARGE_FRUIT_DURATION = LARGE_FRUIT_DURATION;
+		field.LARGE_FRUIT_ENHANCEMENT = LARGE_FRUIT_ENHANCEMENT;
+		field.SKILL_COST = SKILL_COST;
+		field.SelectSimulator();
+		field.PrepareInitialField(fieldStatic, fieldContent);
+	}
+};
+
+// 并查集，用于保证连通
+inline int MapFind(int *parent, int x)
+{
+	while (parent[x] != x)
+		x = parent[x] = parent[parent[x]];
+	return x;
+}
+
+// (r, c) 在四个对称位置上的像，k = 0..3 依次是原位、左右镜像、上下左右镜像、上下镜像
+inline void MapMirror(const PacmanMap &m, int r, int c, int k, int &mr, int &mc)
+{
+	mr = k >= 2 ? m.height - 1 - r : r;
+	mc = k == 1 || k == 2 ? m.width - 1 - c : c;
+}
+
+// 按种子生成一张地图，相同的种子总是得到相同的地图
+inline PacmanMap GenerateMap(unsigned int seed)
+{
+	MapRandom random(seed);
+	PacmanMap m;
+	memset(&m, 0, sizeof(m));
+	m.height = random.Int(MAPGEN_MIN_SIZE, MAPGEN_MAX_SIZE);
+	m.width = random.Int(MAPGEN_MIN_SIZE, MAPGEN_MAX_SIZE);
+	m.GENERATOR_INTERVAL = random.Int(MAPGEN_GENERATOR_INTERVAL);
+	m.LARGE_FRUIT_DURATION = random.Int(MAPGEN_LARGE_FRUIT_DURATION);
+	m.LARGE_FRUIT_ENHANCEMENT = random.Int(MAPGEN_LARGE_FRUIT_ENHANCEMENT);
+	m.SKILL_COST = random.Int(MAPGEN_SKILL_COST);
+	const int H = m.height, W = m.width;
+
+	for (int r = 0; r < H; r++)
+		for (int c = 0; c < W; c++)
+			m.fieldStatic[r][c] = Pacman::wallNorth | Pacman::wallEast | Pacman::wallSouth | Pacman::wallWest;
+
+	// 左上象限（含中线）格子的东墙、南墙，以及穿过边界的北墙、西墙，各代表一组对称的墙
+	std::vector<int> edges;
+	for (int r = 0; r < (H + 1) / 2; r++)
+		for (int c = 0; c < (W + 1) / 2; c++)
+			for (int d = 0; d < 4; d++)
+				if (d == 1 || d == 2 || (d == 0 && r == 0) || (d == 3 && c == 0))
+					edges.push_back((r * FIELD_MAX_WIDTH + c) * 4 + d);
+	for (int i = (int)edges.size() - 1; i > 0; i--)
+		swap(edges[i], edges[random.Int(0, i)]);
+
+	int parent[FIELD_MAX_HEIGHT * FIELD_MAX_WIDTH];
+	for (int i = 0; i < FIELD_MAX_HEIGHT * FIELD_MAX_WIDTH; i++)
+		parent[i] = i;
+
+	// 第一遍只拆能连通新区域的墙组，第二遍按比例拆出环路
+	for (int pass = 0; pass < 2; pass++)
+		for (size_t e = 0; e < edges.size(); e++)
+		{
+			int r = edges[e] / 4 / FIELD_MAX_WIDTH, c = edges[e] / 4 % FIELD_MAX_WIDTH, d = edges[e] % 4;
+			if (!(m.fieldStatic[r][c] & Pacman::direction2OpposingWall[d]))
+				continue;
+
+			bool useful = false;
+			int from[4], to[4];
+			for (int k = 0; k < 4; k++)
+			{
+				// 镜像后方向也跟着翻转：左右镜像翻转东西，上下镜像翻转南北
+				int mr, mc, md = d;
+				MapMirror(m, r, c, k, mr, mc);
+				if ((k == 1 || k == 2) && (md == 1 || md == 3))
+					md ^= 2;
+				if (k >= 2 && (md == 0 || md == 2))
+					md ^= 2;
+				int nr = (mr + Pacman::dy[md] + H) % H, nc = (mc + Pacman::dx[md] + W) % W;
+				from[k] = mr * FIELD_MAX_WIDTH + mc, to[k] = nr * FIELD_MAX_WIDTH + nc;
+				useful |= MapFind(parent, from[k]) != MapFind(parent, to[k]);
+				to[k] = to[k] * 4 + md;
+			}
+			if (pass == 0 ? !useful : !random.Chance(MAPGEN_LOOP))
+				continue;
+
+			for (int k = 0; k < 4; k++)
+			{
+				int md = to[k] % 4, a = from[k], b = to[k] / 4;
+				m.fieldStatic[a / FIELD_MAX_WIDTH][a % FIELD_MAX_WIDTH] &= ~Pacman::direction2OpposingWall[md];
+				m.fieldStatic[b / FIELD_MAX_WIDTH][b % FIELD_MAX_WIDTH] &= ~Pacman::direction2OpposingWall[md ^ 2];
+				parent[MapFind(parent, a)] = MapFind(parent, b);
+			}
+		}
+
+	// 出生点和产生器取在严格的左上象限，保证四个像互不重合
+	int pr = random.Int(0, H / 2 - 1), pc = random.Int(0, W / 2 - 1), gr, gc;
+	do
+		gr = random.Int(0, H / 2 - 1), gc = random.Int(0, W / 2 - 1);
+	while (gr == pr && gc == pc);
+	for (int k = 0; k < 4; k++)
+	{
+		int r, c;
+		MapMirror(m, pr, pc, k, r, c);
+		m.fieldContent[r][c] |= Pacman::playerID2Mask[k];
+		MapMirror(m, gr, gc, k, r, c);
+		m.fieldStatic[r][c] |= Pacman::generator;
+	}
+
+	// 豆子：按组放置，组内是同一格的各个像（中线上的格子像会重合）
+	std::vector<int> cells;
+	for (int r = 0; r < (H + 1) / 2; r++)
+		for (int c = 0; c < (W + 1) / 2; c++)
+			if (!(m.fieldStatic[r][c] & Pacman::generator) && !(m.fieldContent[r][c] & Pacman::playerMask))
+				cells.push_back(r * FIELD_MAX_WIDTH + c);
+	for (int i = (int)cells.size() - 1; i > 0; i--)
+		swap(cells[i], cells[random.Int(0, i)]);
+	for (size_t i = 0; i < cells.size(); i++)
+	{
+		int fruit = (int)i < MAPGEN_LARGE_FRUIT ? Pacman::largeFruit : random.Chance(MAPGEN_SMALL_FRUIT) ? Pacman::smallFruit : 0;
+		for (int k = 0; k < 4 && fruit; k++)
+		{
+			int r, c;
+			MapMirror(m, cells[i] / FIELD_MAX_WIDTH, cells[i] % FIELD_MAX_WIDTH, k, r, c);
+			m.fieldContent[r][c] |= fruit;
+		}
+	}
+	return m;
+}
+
+#endif
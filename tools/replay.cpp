@@ -0,0 +1,119 @@
+/*
+* 二进制回放（replay.h）的查看、校验与转换
+* 编译：g++ -O2 tools/replay.cpp -o replay
+* 用法：
+*  replay 回放.pmr [回合]        打印概况和第几回合（默认终局）开始时的局面
+*  replay -v 回放.pmr...         逐回合校验随机访问和从头演算的结果一致，并统计每次跳转的耗时
+*  replay -c 输入.json 回放.pmr  把平台给 Bot 的输入（requests 历史）转成二进制回放
+*/
+
+#define _PACMAN_LIBRARY
+#include "../main.cpp"
+#include "mapgen.h"
+#include "replay.h"
+
+#include <chrono>
+
+static int Convert(const char *input, const char *output)
+{
+	std::ifstream fin(input);
+	Json::Value root;
+	PacmanMap map;
+	if (!fin || !Json::Reader().parse(fin, root) || !map.FromJson(root["requests"][0u]))
+	{
+		fprintf(stderr, "无法读取 %s\n", input);
+		return 1;
+	}
+
+	ReplayWriter writer;
+	map.Apply(gameField);
+	writer.Begin(map, gameField);
+	for (Json::ArrayIndex t = 1; t < root["requests"].size(); t++)
+	{
+		const Json::Value &req = root["requests"][t];
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			gameField.actions[i] = gameField.players[i].dead ? Pacman::stay : (Pacman::Direction)req[Pacman::playerID2str[i]]["action"].asInt();
+		gameField.NextTurn();
+		writer.Turn(gameField);
+	}
+	if (!writer.Save(output, gameField))
+	{
+		fprintf(stderr, "无法写入 %s\n", output);
+		return 1;
+	}
+	return 0;
+}
+
+static int Verify(int count, char **paths)
+{
+	static Pacman::GameField seeked;
+	int bad = 0;
+	long long seeks = 0;
+	double micros = 0;
+	for (int f = 0; f < count; f++)
+	{
+		ReplayReader reader;
+		if (!reader.Load(paths[f]))
+		{
+			printf("%s: 格式不对\n", paths[f]);
+			bad++;
+			continue;
+		}
+		reader.Map().Apply(gameField);
+		for (int t = 0; t <= reader.Turns(); t++)
+		{
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			reader.Seek(seeked, t);
+			micros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+			seeks++;
+			if (!SameState(seeked, gameField))
+			{
+				printf("%s: 第 %d 回合不一致\n", paths[f], t);
+				bad++;
+				break;
+			}
+			if (t < reader.Turns())
+			{
+				for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+					gameField.actions[i] = reader.Action(t, i);
+				gameField.NextTurn();
+			}
+		}
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			if (gameField.players[i].strength != reader.Score(i))
+			{
+				printf("%s: 终局力量不一致\n", paths[f]);
+				bad++;
+				break;
+			}
+	}
+	printf("%d files, %lld seeks, %.2f us/seek, %d bad\n", count, seeks, micros / std::max(seeks, 1ll), bad);
+	return bad ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 3 && !strcmp(argv[1], "-v"))
+		return Verify(argc - 2, argv + 2);
+	if (argc == 4 && !strcmp(argv[1], "-c"))
+		return Convert(argv[2], argv[3]);
+	if (argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "用法：%s 回放.pmr [回合] | -v 回放.pmr... | -c 输入.json 回放.pmr\n", argv[0]);
+		return 2;
+	}
+
+	ReplayReader reader;
+	if (!reader.Load(argv[1]))
+	{
+		fprintf(stderr, "无法读取回放 %s\n", argv[1]);
+		return 1;
+	}
+	int turn = argc == 3 ? atoi(argv[2]) : reader.Turns();
+	turn = std::max(0, std::min(turn, reader.Turns()));
+	printf("%dx%d, %d turns, final strength %d %d %d %d\n", reader.Map().height, reader.Map().width, reader.Turns(),
+		reader.Score(0), reader.Score(1), reader.Score(2), reader.Score(3));
+	reader.Seek(gameField, turn);
+	gameField.DebugPrint();
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*
+* 二进制回放：初始场地只存一次，之后每回合存 4 个字节的动作，另每隔 REPLAY_INTERVAL 回合存一份完整的局面（检查点）
+* 所有记录都是定长的，跳到第 N 回合只需读出最近的检查点，再用 NextTurn 演算不超过 REPLAY_INTERVAL - 1 个回合
+* 需要在 #include "../main.cpp" 和 "mapgen.h" 之后包含
+*
+* 文件格式（整数均为小端）：
+*  文件头 REPLAY_HEADER_SIZE 字节："PMRP"，版本、检查点间隔、高、宽各 1 字节，回合数、检查点数各 2 字节，
+*    GENERATOR_INTERVAL、LARGE_FRUIT_DURATION、LARGE_FRUIT_ENHANCEMENT、SKILL_COST、四个玩家的终局力量各 4 字节
+*  场地：static、content 各 高*宽 字节
+*  动作：回合数 * 4 字节，第 t 回合第 i 个玩家的动作（有符号）
+*  检查点：每个 高*宽 + REPLAY_STATE_EXTRA 字节，第 k 个是第 k*间隔 回合开始时的局面：
+*    content 高*宽 字节；每个玩家行、列、是否死亡、0 各 1 字节，力量、大豆剩余回合各 4 字节；generatorTurnLeft、aliveCount、smallFruitCount 各 4 字节
+* 从检查点恢复的局面可以继续演算，但不能 PopState 到检查点之前
+*/
+
+#ifndef PACMAN_REPLAY_H
+#define PACMAN_REPLAY_H
+
+#define REPLAY_VERSION 1
+#define REPLAY_INTERVAL 10
+#define REPLAY_HEADER_SIZE 44
+#define REPLAY_STATE_EXTRA (MAX_PLAYER_COUNT * 12 + 12)
+
+inline void ReplayPut32(std::vector<unsigned char> &out, int x)
+{
+	for (int i = 0; i < 4; i++)
+		out.push_back((unsigned char)((unsigned int)x >> (8 * i)));
+}
+
+inline int ReplayGet32(const unsigned char *p)
+{
+	return (int)(p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24);
+}
+
+// 比较两个局面中会随演算变化的部分
+inline bool SameState(const Pacman::GameField &a, const Pacman::GameField &b)
+{
+	if (a.turnID != b.turnID || a.generatorTurnLeft != b.generatorTurnLeft || a.aliveCount != b.aliveCount || a.smallFruitCount != b.smallFruitCount)
+		return false;
+	for (int r = 0; r < a.height; r++)
+		for (int c = 0; c < a.width; c++)
+			if (a.fieldContent[r][c] != b.fieldContent[r][c])
+				return false;
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+	{
+		const Pacman::Player &p = a.players[i], &q = b.players[i];
+		if (p.row != q.row || p.col != q.col || p.dead != q.dead || p.strength != q.strength || p.powerUpLeft != q.powerUpLeft)
+			return false;
+	}
+	return true;
+}
+
+// 对局进行中逐回合记录，终局后写成文件
+class ReplayWriter
+{
+	PacmanMap map;
+	std::vector<signed char> actions;
+	std::vector<unsigned char> checkpoints;
+
+	void Checkpoint(const Pacman::GameField &field)
+	{
+		for (int r = 0; r < map.height; r++)
+			for (int c = 0; c < map.width; c++)
+				checkpoints.push_back((unsigned char)field.fieldContent[r][c]);
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		{
+			const Pacman::Player &p = field.players[i];
+			checkpoints.push_back((unsigned char)p.row);
+			checkpoints.push_back((unsigned char)p.col);
+			checkpoints.push_back(p.dead);
+			checkpoints.push_back(0);
+			ReplayPut32(checkpoints, p.strength);
+			ReplayPut32(checkpoints, p.powerUpLeft);
+		}
+		ReplayPut32(checkpoints, field.generatorTurnLeft);
+		ReplayPut32(checkpoints, field.aliveCount);
+		ReplayPut32(checkpoints, field.smallFruitCount);
+	}
+
+public:
+	// 开始记录一局，field 是已经载入 m 的第 0 回合局面
+	void Begin(const PacmanMap &m, const Pacman::GameField &field)
+	{
+		map = m;
+		actions.clear();
+		checkpoints.clear();
+		Checkpoint(field);
+	}
+
+	// 在 field 演算完一回合之后调用
+	void Turn(const Pacman::GameField &field)
+	{
+		const Pacman::TurnStateTransfer &bt = field.backtrack[field.turnID - 1];
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			actions.push_back((signed char)bt.actions[i]);
+		if (field.turnID % REPLAY_INTERVAL == 0)
+			Checkpoint(field);
+	}
+
+	// 写成文件，终局力量取自 field
+	bool Save(const char *path, const Pacman::GameField &field) const
+	{
+		std::vector<unsigned char> out;
+		int turns = (int)actions.size() / MAX_PLAYER_COUNT, size = map.height * map.width;
+		const char magic[] = "PMRP";
+		out.insert(out.end(), magic, magic + 4);
+		out.push_back(REPLAY_VERSION);
+		out.push_back(REPLAY_INTERVAL);
+		out.push_back((unsigned char)map.height);
+		out.push_back((unsigned char)map.width);
+		out.push_back((unsigned char)turns), out.push_back((unsigned char)(turns >> 8));
+		int count = (int)checkpoints.size() / (size + REPLAY_STATE_EXTRA);
+		out.push_back((unsigned char)count), out.push_back((unsigned char)(count >> 8));
+		ReplayPut32(out, map.GENERATOR_INTERVAL);
+		ReplayPut32(out, map.LARGE_FRUIT_DURATION);
+		ReplayPut32(out, map.LARGE_FRUIT_ENHANCEMENT);
+		ReplayPut32(out, map.SKILL_COST);
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			ReplayPut32(out, field.players[i].strength);
+		for (int r = 0; r < map.height; r++)
+			for (int c = 0; c < map.width; c++)
+				out.push_back((unsigned char)map.fieldStatic[r][c]);
+		for (int r = 0; r < map.height; r++)
+			for (int c = 0; c < map.width; c++)
+				out.push_back((unsigned char)map.fieldContent[r][c]);
+		out.insert(out.end(), actions.begin(), actions.end());
+		out.insert(out.end(), checkpoints.begin(), checkpoints.end());
+
+		FILE *f = fopen(path, "wb");
+		if (!f)
+			return false;
+		bool ok = fwrite(&out[0], 1, out.size(), f) == out.size();
+		return fclose(f) == 0 && ok;
+	}
+};
+
+// 读入整个回放文件，之后可以随机访问任意回合
+class ReplayReader
+{
+	std::vector<unsigned char> bytes;
+	PacmanMap map;
+	int turns, interval, checkpointCount, score[MAX_PLAYER_COUNT];
+	size_t actionOffset, checkpointOffset, checkpointSize;
+
+public:
+	// 文件不存在或格式不对返回 false
+	bool Load(const char *path)
+	{
+		std::ifstream fin(path, std::ios::binary);
+		if (!fin)
+			return false;
+		bytes.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+		if (bytes.size() < REPLAY_HEADER_SIZE || memcmp(&bytes[0], "PMRP", 4) || bytes[4] != REPLAY_VERSION)
+			return false;
+
+		const unsigned char *p = &bytes[0];
+		interval = p[5];
+		memset(&map, 0, sizeof(map));
+		map.height = p[6], map.width = p[7];
+		turns = p[8] | p[9] << 8;
+		checkpointCount = p[10] | p[11] << 8;
+		map.GENERATOR_INTERVAL = ReplayGet32(p + 12);
+		map.LARGE_FRUIT_DURATION = ReplayGet32(p + 16);
+		map.LARGE_FRUIT_ENHANCEMENT = ReplayGet32(p + 20);
+		map.SKILL_COST = ReplayGet32(p + 24);
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			score[i] = ReplayGet32(p + 28 + 4 * i);
+		if (!interval || map.height > FIELD_MAX_HEIGHT || map.width > FIELD_MAX_WIDTH || turns > MAX_TURN)
+			return false;
+
+		int size = map.height * map.width;
+		actionOffset = REPLAY_HEADER_SIZE + 2 * size;
+		checkpointOffset = actionOffset + turns * MAX_PLAYER_COUNT;
+		checkpointSize = size + REPLAY_STATE_EXTRA;
+		if (bytes.size() != checkpointOffset + checkpointCount * checkpointSize || checkpointCount <= turns / interval)
+			return false;
+		for (int r = 0; r < map.height; r++)
+			for (int c = 0; c < map.width; c++)
+			{
+				map.fieldStatic[r][c] = bytes[REPLAY_HEADER_SIZE + r * map.width + c];
+				map.fieldContent[r][c] = bytes[REPLAY_HEADER_SIZE + size + r * map.width + c];
+			}
+		return true;
+	}
+
+	int Turns() const
+	{
+		return turns;
+	}
+	const PacmanMap &Map() const
+	{
+		return map;
+	}
+	int Score(int player) const
+	{
+		return score[player];
+	}
+	// 第 turn 回合（从 0 开始）player 的动作
+	Pacman::Direction Action(int turn, int player) const
+	{
+		return (Pacman::Direction)(signed char)bytes[actionOffset + turn * MAX_PLAYER_COUNT + player];
+	}
+
+	// 把 field 设为第 turn 回合开始时（0 <= turn <= Turns()）的局面
+	void Seek(Pacman::GameField &field, int turn) const
+	{
+		int k = turn / interval;
+		const unsigned char *p = &bytes[checkpointOffset + k * checkpointSize];
+		map.Apply(field);
+		for (int r = 0; r < map.height; r++)
+			for (int c = 0; c < map.width; c++)
+				field.fieldContent[r][c] = (Pacman::GridContentType)*p++;
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++, p += 12)
+		{
+			Pacman::Player &pl = field.players[i];
+			pl.row = p[0], pl.col = p[1], pl.dead = p[2];
+			pl.strength = ReplayGet32(p + 4);
+			pl.powerUpLeft = ReplayGet32(p + 8);
+		}
+		field.generatorTurnLeft = ReplayGet32(p);
+		field.aliveCount = ReplayGet32(p + 4);
+		field.smallFruitCount = ReplayGet32(p + 8);
+		field.turnID = k * interval;
+
+		while (field.turnID < turn)
+		{
+			for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+				field.actions[i] = Action(field.turnID, i);
+			field.NextTurn();
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*
+* 进程内自对弈：四个座位都直接调用 BotDecide，不启动进程也不解析 JSON 历史，用于大量对局的调参
+* 编译：g++ -O2 tools/selfplay.cpp -o selfplay
+* 用法：selfplay [-n 局数] [-s 种子] [-r 回放目录] [地图.json...]
+*  地图是平台第一条 request 的格式，各局轮流使用；不给地图就用 mapgen.h 按 种子+局号 生成
+*  -r 给出时每局写一份 replay.h 格式的回放 game-局号.pmr
+*  每个座位各自保存 data 和跨局的 globaldata
+*/
+
+#define _PACMAN_LIBRARY
+#include "../main.cpp"
+#include "mapgen.h"
+#include "replay.h"
+
+#include <chrono>
+
+// 裁判的局面，和 Bot 使用的 gameField 分开
+static Pacman::GameField referee;
+
+int main(int argc, char **argv)
+{
+	int games = 1, opt;
+	unsigned int seed = 1478417566;
+	const char *replayDir = NULL;
+	while ((opt = getopt(argc, argv, "n:s:r:")) != -1)
+		switch (opt)
+		{
+		case 'n': games = atoi(optarg); break;
+		case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+		case 'r': replayDir = optarg; break;
+		default: return 2;
+		}
+
+	std::vector<PacmanMap> maps(argc - optind);
+	for (int i = optind; i < argc; i++)
+	{
+		std::ifstream fin(argv[i]);
+		Json::Value map;
+		if (!fin || !Json::Reader().parse(fin, map) || !maps[i - optind].FromJson(map))
+		{
+			fprintf(stderr, "无法读取地图 %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	string state[MAX_PLAYER_COUNT], globalState[MAX_PLAYER_COUNT];
+	long long strength[MAX_PLAYER_COUNT] = {}, decisions = 0;
+	double maxMs = 0;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	RR = seed;
+
+	for (int g = 0; g < games; g++)
+	{
+		PacmanMap map = maps.empty() ? GenerateMap(seed + g) : maps[g % maps.size()];
+		map.Apply(referee);
+		ReplayWriter replay;
+		replay.Begin(map, referee);
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			state[i].clear();
+
+		bool running = true;
+		while (running)
+		{
+			for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+				if (!referee.players[i].dead)
+				{
+					std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+					referee.actions[i] = BotDecide(referee, i, state[i], globalState[i]);
+					maxMs = std::max(maxMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count());
+					decisions++;
+				}
+			running = referee.NextTurn();
+			replay.Turn(referee);
+		}
+
+		if (replayDir)
+		{
+			char name[4096];
+			snprintf(name, sizeof(name), "%s/game-%d.pmr", replayDir, g);
+			replay.Save(name, referee);
+		}
+
+		printf("game %d turns %d |", g, referee.turnID);
+		for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+			printf(" %d", referee.players[i].strength), strength[i] += referee.players[i].strength;
+		putchar('\n');
+		fflush(stdout);
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	printf("%d games, %lld decisions in %.1f s: %.0f games/hour, %.2f ms/decision (max %.2f)\n", games, decisions, seconds,
+		games / seconds * 3600, seconds * 1000 / std::max(decisions, 1ll), maxMs);
+	printf("mean strength by seat:");
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		printf(" %.2f", (double)strength[i] / std::max(games, 1));
+	putchar('\n');
+	return 0;
+}
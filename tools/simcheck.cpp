@@ -0,0 +1,193 @@
+/*
+* 演算的差分校验：针对场地尺寸特化的 NextTurnT/PopStateT 与通用版本 <0, 0> 并排运行，逐回合比较结果
+* 编译：g++ -O2 tools/simcheck.cpp -o simcheck
+* 用法：simcheck [-n 局数] [-s 起始种子]
+*  每局用 mapgen.h 按 种子+局号 生成 6~12 的场地，双方喂入同样的随机动作（含发射金光和不合法的动作）直到终局，
+*  每回合比较局面和 backtrack 记录，终局后再一路恢复到第 0 回合逐回合比较
+*  另外随机摆放大量多人同格的局面，比较 SettleFights 与原先逐格冒泡排序的结算结果
+*/
+
+#define _PACMAN_LIBRARY
+#include "../main.cpp"
+#include "mapgen.h"
+#include "replay.h"
+
+// 特化版本和通用版本各自的局面
+static Pacman::GameField fast, slow;
+static int totalTurns;
+
+static bool SameTransfer(const Pacman::TurnStateTransfer &a, const Pacman::TurnStateTransfer &b)
+{
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+		if (a.actions[i] != b.actions[i] || a.change[i] != b.change[i] || a.strengthDelta[i] != b.strengthDelta[i])
+			return false;
+	return true;
+}
+
+// 原先 NextTurn 第 2 步的写法：每个活着的玩家都把自己格子上的玩家按力量冒泡排序后结算
+static void ReferenceFights(Pacman::GameField &field, Pacman::TurnStateTransfer &bt)
+{
+	using namespace Pacman;
+	int _, i, j;
+	for (_ = 0; _ < MAX_PLAYER_COUNT; _++)
+	{
+		Player &_p = field.players[_];
+		if (_p.dead)
+			continue;
+
+		int player, containedCount = 0;
+		int containedPlayers[MAX_PLAYER_COUNT];
+		for (player = 0; player < MAX_PLAYER_COUNT; player++)
+			if (field.fieldContent[_p.row][_p.col] & playerID2Mask[player])
+				containedPlayers[containedCount++] = player;
+
+		if (containedCount > 1)
+		{
+			for (i = 0; i < containedCount; i++)
+				for (j = 0; j < containedCount - i - 1; j++)
+					if (field.players[containedPlayers[j]].strength < field.players[containedPlayers[j + 1]].strength)
+						swap(containedPlayers[j], containedPlayers[j + 1]);
+
+			int begin;
+			for (begin = 1; begin < containedCount; begin++)
+				if (field.players[containedPlayers[begin - 1]].strength > field.players[containedPlayers[begin]].strength)
+					break;
+
+			int lootedStrength = 0;
+			for (i = begin; i < containedCount; i++)
+			{
+				int id = containedPlayers[i];
+				Player &p = field.players[id];
+				field.fieldContent[p.row][p.col] &= ~playerID2Mask[id];
+				p.dead = true;
+				int drop = p.strength / 2;
+				bt.strengthDelta[id] += -drop;
+				bt.change[id] |= TurnStateTransfer::die;
+				lootedStrength += drop;
+				p.strength -= drop;
+				field.aliveCount--;
+			}
+
+			int inc = lootedStrength / begin;
+			for (i = 0; i < begin; i++)
+			{
+				int id = containedPlayers[i];
+				bt.strengthDelta[id] += inc;
+				field.players[id].strength += inc;
+			}
+		}
+	}
+}
+
+// 给 field 中每个玩家随机选一个动作：大多是能走的方向，偶尔发射金光或者故意撞墙
+static void RandomActions(Pacman::GameField &field, MapRandom &random)
+{
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+	{
+		Pacman::Direction d = Pacman::Direction(random.Int(-1, 3));
+		if (random.Chance(0.05))
+			d = Pacman::Direction(random.Int(4, 7));
+		else if (!random.Chance(0.005))
+			for (int k = 0; k < 4 && !field.ActionValid(i, d); k++)
+				d = Pacman::Direction(random.Int(-1, 3));
+		field.actions[i] = d;
+	}
+}
+
+// 跑一局，返回第一处不一致的回合，一致返回 -1
+static int CheckGame(unsigned int seed)
+{
+	PacmanMap map = GenerateMap(seed);
+	map.Apply(fast);
+	map.Apply(slow);
+	slow.popStateImpl = &Pacman::GameField::PopStateT<0, 0>;
+	slow.nextTurnImpl = &Pacman::GameField::NextTurnT<0, 0>;
+
+	MapRandom random(~seed);
+	bool going = true;
+	while (going)
+	{
+		RandomActions(fast, random);
+		memcpy(slow.actions, fast.actions, sizeof(fast.actions));
+		int turn = fast.turnID;
+		totalTurns++;
+		going = fast.NextTurn();
+		if (slow.NextTurn() != going || !SameState(fast, slow) || !SameTransfer(fast.backtrack[turn], slow.backtrack[turn]))
+			return turn;
+	}
+	while (fast.turnID > 0)
+	{
+		fast.PopState();
+		slow.PopState();
+		if (!SameState(fast, slow))
+			return fast.turnID;
+	}
+	return -1;
+}
+
+// 随机摆一个多人同格的局面，比较两种结算，一致返回 true
+static bool CheckFights(MapRandom &random)
+{
+	int cells = random.Int(1, 3);
+	for (int r = 0; r < fast.height; r++)
+		for (int c = 0; c < fast.width; c++)
+			fast.fieldContent[r][c] &= ~Pacman::playerMask;
+	fast.aliveCount = 0;
+	for (int i = 0; i < MAX_PLAYER_COUNT; i++)
+	{
+		Pacman::Player &p = fast.players[i];
+		int k = random.Int(0, cells - 1);
+		p.row = k, p.col = k;
+		p.strength = random.Int(1, 6) * 2 + random.Int(0, 1) * random.Int(0, 1);
+		p.dead = random.Chance(0.15);
+		if (!p.dead)
+		{
+			fast.fieldContent[p.row][p.col] |= Pacman::playerID2Mask[i];
+			fast.aliveCount++;
+		}
+	}
+
+	slow.aliveCount = fast.aliveCount;
+	memcpy(slow.players, fast.players, sizeof(fast.players));
+	memcpy(slow.fieldContent, fast.fieldContent, sizeof(fast.fieldContent));
+
+	Pacman::TurnStateTransfer a, b;
+	memset(&a, 0, sizeof(a));
+	memset(&b, 0, sizeof(b));
+	fast.SettleFights(a);
+	ReferenceFights(slow, b);
+	return SameState(fast, slow) && SameTransfer(a, b);
+}
+
+int main(int argc, char **argv)
+{
+	int games = 1000, opt;
+	unsigned int seed = 1;
+	while ((opt = getopt(argc, argv, "n:s:")) != -1)
+		switch (opt)
+		{
+		case 'n': games = atoi(optarg); break;
+		case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+		default: return 2;
+		}
+
+	int bad = 0;
+	for (int g = 0; g < games; g++)
+	{
+		int at = CheckGame(seed + g);
+		if (at >= 0)
+		{
+			printf("种子 %u：第 %d 回合不一致\n", seed + g, at);
+			bad++;
+		}
+	}
+
+	// 借用最后一局的场地摆放同格的玩家
+	MapRandom random(seed);
+	int fights = games * 100, badFights = 0;
+	for (int k = 0; k < fights; k++)
+		badFights += !CheckFights(random);
+
+	printf("%d 局（%d 回合）%d 不一致，%d 个同格局面 %d 不一致\n", games, totalTurns, bad, fights, badFights);
+	return bad || badFights;
+}